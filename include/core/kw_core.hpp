@@ -85,6 +85,10 @@ namespace KalaWindow::Core
 		static u32 GetGlobalID();
 		static void SetGlobalID(u32 newID);
 
+		//Returns monotonic time in nanoseconds, on Linux this is CLOCK_MONOTONIC
+		//so it can be compared against X server and presentation timestamps
+		static u64 GetMonotonicTime();
+
 		static path GetExePath();
 
 		//Get CPU info as individual fields in a struct
@@ -0,0 +1,114 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include "core_utils.hpp"
+
+#if defined(KLIN_ANY)
+
+#include <string_view>
+
+namespace KalaWindow::Graphics
+{
+	class ProcessWindow;
+}
+
+namespace KalaWindow::Core
+{
+	using std::string_view;
+
+	//How many gamepads can be connected at the same time, extra devices are ignored
+	static constexpr u8 MAX_GAMEPADS = 8;
+
+	//Buttons are named after their position on an Xbox style controller
+	enum class GamepadButton : u8
+	{
+		GAMEPAD_A,
+		GAMEPAD_B,
+		GAMEPAD_X,
+		GAMEPAD_Y,
+
+		GAMEPAD_LEFT_BUMPER,
+		GAMEPAD_RIGHT_BUMPER,
+
+		GAMEPAD_BACK,
+		GAMEPAD_START,
+		GAMEPAD_GUIDE,
+
+		GAMEPAD_LEFT_STICK,
+		GAMEPAD_RIGHT_STICK,
+
+		GAMEPAD_DPAD_UP,
+		GAMEPAD_DPAD_DOWN,
+		GAMEPAD_DPAD_LEFT,
+		GAMEPAD_DPAD_RIGHT
+	};
+	static constexpr u8 GAMEPAD_BUTTON_COUNT = 15;
+
+	enum class GamepadAxis : u8
+	{
+		GAMEPAD_LEFT_X,       //-1 to +1, left to right
+		GAMEPAD_LEFT_Y,       //-1 to +1, up to down
+		GAMEPAD_RIGHT_X,      //-1 to +1, left to right
+		GAMEPAD_RIGHT_Y,      //-1 to +1, up to down
+		GAMEPAD_LEFT_TRIGGER, //0 to 1
+		GAMEPAD_RIGHT_TRIGGER //0 to 1
+	};
+	static constexpr u8 GAMEPAD_AXIS_COUNT = 6;
+
+	//Gamepads and joysticks read directly from evdev on a dedicated thread,
+	//devices are picked up and dropped through /dev/input hotplug.
+	//The reader thread stamps events with CLOCK_MONOTONIC and writes them into lock-free
+	//per-slot state, ProcessWindow::Update latches that into per-frame state for these getters.
+	//All getters must be called from the main thread
+	class LIB_API Gamepad
+	{
+	friend class KalaWindow::Graphics::ProcessWindow;
+	public:
+		static bool IsVerboseLoggingEnabled();
+		static void SetVerboseLoggingState(bool newState);
+
+		//Start the reader thread, already connected gamepads are opened right away.
+		//The user needs read access to /dev/input/event*, usually through the input group or udev rules
+		static bool Initialize();
+		static bool IsInitialized();
+
+		//Stop the reader thread and close all gamepads, also called when the last window is destroyed
+		static void Shutdown();
+
+		//Is a gamepad connected to this slot
+		static bool IsConnected(u8 slot);
+		//Get the device name reported by the gamepad at this slot
+		static string_view GetName(u8 slot);
+
+		//Is the button currently held down
+		static bool IsButtonHeld(
+			u8 slot,
+			GamepadButton button);
+		//Was the button pressed since last frame, true even if it was already released again
+		static bool IsButtonPressed(
+			u8 slot,
+			GamepadButton button);
+		//Was the button released since last frame
+		static bool IsButtonReleased(
+			u8 slot,
+			GamepadButton button);
+
+		//Get the normalized axis value, the device deadzone is already applied
+		static f32 GetAxis(
+			u8 slot,
+			GamepadAxis axis);
+
+		//Returns the KalaWindowCore::GetMonotonicTime timestamp of the newest event
+		//from the gamepad at this slot, 0 if it has not sent any events
+		static u64 GetLastEventTime(u8 slot);
+	private:
+		//Latch reader thread state into per-frame state
+		static void Update();
+	};
+}
+
+#endif //KLIN_ANY
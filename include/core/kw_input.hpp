@@ -19,6 +19,7 @@
 namespace KalaWindow::Graphics
 {
 	class ProcessWindow;
+	class VulkanContext;
 }
 
 namespace KalaWindow::Core
@@ -30,7 +31,6 @@ namespace KalaWindow::Core
 	using std::span;
 	using std::string;
 	using std::string_view;
-	using std::default_delete;
 
 	using KalaHeaders::KalaMath::vec2;
 	using KalaHeaders::KalaKeyStandards::KeyboardButton;
@@ -44,11 +44,28 @@ namespace KalaWindow::Core
 		MouseButton mb{};
 	};
 
+	//Edit commands interleaved with typed code points in Input::GetTextInput,
+	//typed control characters never show up as text so these cannot be confused with it
+	static constexpr u32 TEXT_INPUT_BACKSPACE = 0x08;
+	static constexpr u32 TEXT_INPUT_TAB = 0x09;
+	static constexpr u32 TEXT_INPUT_NEWLINE = 0x0A;
+
+	//How many timestamped pointer samples are kept per input for cursor prediction
+	static constexpr u8 MOUSE_HISTORY_SIZE = 16;
+
+	struct MouseSample
+	{
+		vec2 pos{};
+		u64 time{}; //KalaWindowCore::GetMonotonicTime nanoseconds
+	};
+
 	class LIB_API Input
 	{
 	friend class KalaWindow::Graphics::ProcessWindow;
+	friend class KalaWindow::Graphics::VulkanContext;
 	friend class MessageLoop;
-	friend struct default_delete<Input>;
+	friend class StateSnapshot;
+	friend struct KalaWindowRegistry<Input>;
 	public:
 		static KalaWindowRegistry<Input>& GetRegistry();
 
@@ -60,8 +77,12 @@ namespace KalaWindow::Core
 		u32 GetID() const;
 		u32 GetWindowID() const;
 
-		//Get the letter that was typed this frame
+		//Get the text that was typed this frame as UTF-8, without edit commands
 		const string& GetTypedLetter() const;
+		//Get everything that was typed this frame as UTF-32 code points in the order it was typed,
+		//backspace, tab and return presses are interleaved as TEXT_INPUT_BACKSPACE,
+		//TEXT_INPUT_TAB and TEXT_INPUT_NEWLINE. Valid until the end of this frame
+		span<const u32> GetTextInput() const;
 		
 		//Get the keys currently pressed this frame
 		vector<KeyboardButton> GetPressedKeys();
@@ -108,6 +129,11 @@ namespace KalaWindow::Core
 
 		//Get current mouse position in window coordinates
 		vec2 GetMousePosition() const;
+		//Get the predicted mouse position in window coordinates at targetTime,
+		//which is in KalaWindowCore::GetMonotonicTime nanoseconds, usually the expected present time.
+		//Extrapolates from recent pointer velocity and acceleration, returns the current position
+		//if there is not enough recent motion to predict from
+		vec2 PredictMousePosition(u64 targetTime) const;
 		//Get mouse delta movement since last frame
 		vec2 GetMouseDelta();
 		//Get mouse raw delta movement since last frame
@@ -127,7 +153,9 @@ namespace KalaWindow::Core
 		bool IsMouseLocked() const;
 		//Allows to set the lock state of the cursor, if true 
 		//then the cursor is locked to the center of the window,
-		//if updateBetweenFocus is true, then mouse lock is disabled when unfocused without clearing internal flag
+		//if updateBetweenFocus is true, then mouse lock is disabled when unfocused without clearing internal flag.
+		//On X11 this is a relative mode: the pointer is confined to the window,
+		//use GetRawMouseDelta for movement and the cursor is only recentered near the window edges
 		void SetMouseLockState(
 			bool newState,
 			bool updateBetweenFocus = true);
@@ -146,7 +174,13 @@ namespace KalaWindow::Core
 
 		static Input* Initialize(u32 windowID);
 
-		void SetTypedLetter(string_view letter);
+		//Appends a typed code point to this frame's text input, every control character is dropped
+		//because edit keys and ctrl combinations also arrive as text and were already seen as key events
+		void AddTextInput(u32 codePoint);
+		//Appends TEXT_INPUT_BACKSPACE, TEXT_INPUT_TAB or TEXT_INPUT_NEWLINE, only called from key events
+		void AddTextCommand(u32 command);
+		//Appends a UTF-16 code unit, surrogate pairs are combined across calls
+		void AddTextInputUTF16(u16 codeUnit);
 
 		void SetKeyState(
 			KeyboardButton key,
@@ -158,12 +192,28 @@ namespace KalaWindow::Core
 			MouseButton mouseButton,
 			bool isDown);
 
+		//Stores the OS timestamp of an input event if it is the oldest one not yet consumed by a frame,
+		//a timestamp no frame consumed within one frame is dropped
+		void RecordEventTime(u64 time);
+		//Returns the timestamp of the oldest unconsumed input event and resets it, 0 if there was none
+		u64 ConsumeEventTime();
+
+		//Stores a pointer position with its event timestamp for cursor prediction
+		void AddMouseSample(
+			vec2 pos,
+			u64 time);
+		//Forgets all pointer samples, called when the pointer jumps instead of moving
+		void ClearMouseHistory();
+
 		void EndFrameUpdate();
 
 		u32 ID{};
 		u32 windowID{};
 
 		string lastLetter{};
+		vector<u32> textInput{};
+		//High surrogate waiting for its low half, Windows sends them as separate messages
+		u16 pendingHighSurrogate{};
 
 		array<
 			bool,
@@ -199,10 +249,24 @@ namespace KalaWindow::Core
 		bool isMouseLocked = false;
 		bool keepMouseDelta = false;
 
+#if defined(KLIN_ANY)
+		//If true, then the next motion event is the result of our own pointer warp
+		bool isWarpPending = false;
+		//Request serial of the last pointer warp, motion events at or after it are post-warp
+		u64 warpSerial{};
+#endif
+
 		vec2 mousePos = vec2{ 0.0f, 0.0f };
 		vec2 mouseDelta = vec2{ 0.0f, 0.0f };
 		vec2 rawMouseDelta = vec2{ 0.0f, 0.0f };
 
 		f32 mouseWheelDelta = 0.0f;
+
+		u64 pendingEventTime{};
+		bool isEventTimeStale{}; //pendingEventTime already outlived one EndFrameUpdate
+
+		array<MouseSample, MOUSE_HISTORY_SIZE> mouseHistory{};
+		u8 mouseHistoryNext{};
+		u8 mouseHistoryCount{};
 	};
 }
\ No newline at end of file
@@ -7,88 +7,257 @@
 
 #include "core_utils.hpp"
 
-#include <unordered_map>
+#include <array>
 #include <vector>
+#include <span>
+#include <unordered_map>
 #include <memory>
-#include <algorithm>
+#include <new>
+#include <atomic>
+#include <thread>
+#include <chrono>
 #include <type_traits>
 
 namespace KalaWindow::Core
 {
-	using std::unordered_map;
+	using std::array;
 	using std::vector;
+	using std::span;
+	using std::unordered_map;
 	using std::unique_ptr;
 	using std::make_unique;
-	using std::find;
-	using std::remove;
-	using std::remove_if;
 	using std::is_class_v;
+	using std::atomic;
+	using std::memory_order_relaxed;
+	using std::memory_order_acquire;
+	using std::memory_order_release;
+	using std::memory_order_seq_cst;
+
+	//How many objects are stored next to each other in a single registry page
+	static constexpr u32 REGISTRY_PAGE_SIZE = 64;
+	//Slot indexes are 16 bits, so this is the most objects a registry can hold
+	static constexpr u32 REGISTRY_MAX_SLOTS = 0xFFFF;
+	static constexpr u32 REGISTRY_MAX_PAGES =
+		(REGISTRY_MAX_SLOTS + REGISTRY_PAGE_SIZE - 1) / REGISTRY_PAGE_SIZE;
+
+	//How many KalaWindowRegistryReadGuards can be alive at the same time across all threads
+	static constexpr u32 MAX_REGISTRY_READERS = 64;
+
+	//IDs are 4-bit registry tag + 12-bit generation + 16-bit slot index
+	static constexpr u32 REGISTRY_TAG_SHIFT = 28;
+	static constexpr u32 REGISTRY_GENERATION_SHIFT = 16;
+	static constexpr u32 REGISTRY_GENERATION_MASK = 0xFFF;
+	//Registries past this many share tags again, so their IDs can be mixed up
+	static constexpr u32 REGISTRY_MAX_TAGS = 15;
+
+	//Hands out registry tags in the order registries are first used, starts at 1 so no ID is 0
+	inline atomic<u32> nextRegistryTag{ 0 };
+
+	template<typename T>
+		requires is_class_v<T>
+	struct KalaWindowRegistry;
+
+	//Placeholder hot state for classes that do not declare 'T::HotState'
+	struct NoHotState {};
+
+	template<typename T>
+	struct RegistryHotState { using type = NoHotState; };
+	template<typename T>
+		requires requires { typename T::HotState; }
+	struct RegistryHotState<T> { using type = typename T::HotState; };
+
+	//Hold one of these on any thread other than the main thread while looking up
+	//registry content and while using the returned pointers. Objects removed on the main thread
+	//are only destroyed after every guard that could have seen them is released,
+	//so keep guards short and never wait on the main thread while holding one.
+	//The main thread must not hold one, it owns all structural changes and would wait on itself
+	class KalaWindowRegistryReadGuard
+	{
+	template<typename T>
+		requires is_class_v<T>
+	friend struct KalaWindowRegistry;
+	public:
+		KalaWindowRegistryReadGuard()
+		{
+			while (true)
+			{
+				u64 epoch = globalEpoch.load(memory_order_seq_cst);
+
+				for (u32 i = 0; i < MAX_REGISTRY_READERS; ++i)
+				{
+					u64 expected = 0;
+					if (readerEpochs[i].compare_exchange_strong(
+						expected,
+						epoch,
+						memory_order_seq_cst))
+					{
+						readerSlot = i;
+						return;
+					}
+				}
+
+				//every reader slot is taken, wait for one to be released
+				std::this_thread::yield();
+			}
+		}
+		~KalaWindowRegistryReadGuard()
+		{
+			readerEpochs[readerSlot].store(0, memory_order_release);
+		}
+
+		KalaWindowRegistryReadGuard(const KalaWindowRegistryReadGuard&) = delete;
+		KalaWindowRegistryReadGuard& operator=(const KalaWindowRegistryReadGuard&) = delete;
+	private:
+		//Called by the writer after unlisting an object and before destroying it,
+		//returns once no guard pinned before the unlisting is alive anymore
+		static inline void WaitForReaders()
+		{
+			u64 newEpoch = globalEpoch.fetch_add(1, memory_order_seq_cst) + 1;
+
+			for (auto& reader : readerEpochs)
+			{
+				u32 attempts{};
+
+				while (true)
+				{
+					u64 epoch = reader.load(memory_order_seq_cst);
+					if (epoch == 0
+						|| epoch >= newEpoch)
+					{
+						break;
+					}
+
+					//guards are short, so yield first and only sleep if a reader is descheduled
+					if (++attempts < WAIT_YIELD_ATTEMPTS) std::this_thread::yield();
+					else std::this_thread::sleep_for(std::chrono::microseconds(50));
+				}
+			}
+		}
+
+		static constexpr u32 WAIT_YIELD_ATTEMPTS = 64;
+
+		u32 readerSlot{};
+
+		static inline atomic<u64> globalEpoch{ 1 };
+		//Epoch each reader pinned at, 0 if the reader slot is free
+		static inline array<atomic<u64>, MAX_REGISTRY_READERS> readerEpochs{};
+	};
 
-	//Stores unique_ptrs and non-owning pointers of class T for ID-based lookups,
-	//should always be stored as 'static inline KalaWindowRegistry<T> registry'
+	//Slot-map of class T objects with generational IDs,
+	//should always be stored as 'static inline KalaWindowRegistry<T> registry'.
+	//IDs are 4-bit registry tag + 12-bit generation + 16-bit slot index. The generation keeps an ID
+	//of a removed object from finding whatever was created into its slot later, unless the slot was
+	//reused 4094 times since. The tag keeps an ID of one registry from finding content in another,
+	//such as a window looked up with an input ID. IDs are never 0 or UINT32_MAX.
+	//Objects are constructed in place inside fixed pages, so their pointers stay valid until
+	//they are removed. T must befriend KalaWindowRegistry<T> if its destructor is private.
+	//If T declares a 'HotState' struct, the registry also keeps one per object in a dense array
+	//in the same order as GetAllContent, so per-frame passes can run over small contiguous
+	//state instead of the full objects.
+	//Only the main thread may add or remove content. GetContent by ID and IsOwner are wait-free
+	//and safe from any thread that holds a KalaWindowRegistryReadGuard, everything else is main thread only
 	template<typename T>
 		requires is_class_v<T>
 	struct LIB_API KalaWindowRegistry
 	{
-		//Get a runtime-safe list of all created object IDs
+		using HotState = typename RegistryHotState<T>::type;
+
+		//Get a runtime-safe list of all created objects, order changes when objects are removed
 		static const vector<T*>& GetAllContent() { return runtimeContent; }
 
-		//Get non-owning value by ID or index
+		//Get hot state of all created objects, index i belongs to GetAllContent()[i].
+		//Invalidated when content is added or removed
+		template<typename U = T>
+			requires requires { typename U::HotState; }
+		static inline span<HotState> GetAllHotContent() { return hotContent; }
+
+		//Get hot state by ID, returns nullptr if the ID is stale.
+		//Invalidated when content is added or removed
+		template<typename U = T>
+			requires requires { typename U::HotState; }
+		static inline HotState* GetHotContent(u32 targetID)
+		{
+			Slot* slot = GetSlot(targetID);
+			return slot
+				? &hotContent[slot->denseIndex]
+				: nullptr;
+		}
+
+		//Get non-owning value by ID or index, returns nullptr if the ID is stale
 		static inline T* GetContent(
 			u32 targetValue,
 			bool getByID = true)
 		{
-			if (getByID)
-			{
-				auto it = createdContent.find(targetValue);
-				return it != createdContent.end()
-					? it->second.get()
-					: nullptr;
-			}
-			else
+			if (!getByID)
 			{
 				return targetValue < runtimeContent.size()
 					? runtimeContent[targetValue]
 					: nullptr;
 			}
+
+			Slot* slot = GetSlot(targetValue);
+			return slot
+				? slot->Get()
+				: nullptr;
 		}
 
-		//Add a new unique ptr and its ID
-		static inline bool AddContent(
-			u32 targetID,
-			unique_ptr<T> targetContent)
+		//Construct a new object in place and return its ID, returns 0 if the registry is full.
+		//T must be default constructible, the registry owns it and picks its ID.
+		//Pass the ID of the window that owns the object to list it in that window's content
+		static inline u32 AddContent(u32 windowID = 0)
 		{
-			if (!targetContent
-				|| targetID == 0
-				|| createdContent.contains(targetID))
+			u32 index{};
+
+			if (freeHead != NO_SLOT)
+			{
+				index = freeHead;
+				freeHead = SlotAt(index).nextFree;
+			}
+			else
 			{
-				return false;
+				if (slotCount >= REGISTRY_MAX_SLOTS) return 0;
+
+				index = slotCount++;
+
+				atomic<Page*>& page = pageTable.pages[index / REGISTRY_PAGE_SIZE];
+				if (!page.load(memory_order_relaxed)) page.store(new Page(), memory_order_release);
 			}
 
-			T* raw = targetContent.get();
-			createdContent[targetID] = std::move(targetContent);
-			runtimeContent.push_back(raw);
+			Slot& slot = SlotAt(index);
 
-			return true;
+			new (slot.storage) T();
+
+			u16 generation = StateGeneration(slot.state.load(memory_order_relaxed));
+
+			//published after construction so readers never see a half-built object
+			slot.state.store(MakeState(generation, true), memory_order_release);
+			slot.denseIndex = scast<u16>(runtimeContent.size());
+			slot.windowID = windowID;
+
+			runtimeContent.push_back(slot.Get());
+			denseSlots.push_back(scast<u16>(index));
+			if constexpr (HAS_HOT_STATE) hotContent.push_back({});
+
+			if (windowID != 0)
+			{
+				WindowContent& wc = windowContent[windowID];
+
+				slot.windowIndex = scast<u16>(wc.content.size());
+
+				wc.content.push_back(slot.Get());
+				wc.slots.push_back(scast<u16>(index));
+			}
+
+			return MakeID(generation, index);
 		}
 
 		//Remove content by ID
 		static inline bool RemoveContent(u32 targetID)
 		{
-			auto it = createdContent.find(targetID);
-			if (it == createdContent.end()) return false; 
-			
-			T* targetPtr = it->second.get();
-			
-			runtimeContent.erase(
-				remove_if(runtimeContent.begin(), runtimeContent.end(),
-					[&](T* p)
-					{
-						return p && p == targetPtr;
-					}),
-				runtimeContent.end());
+			Slot* slot = GetSlot(targetID);
+			if (!slot) return false;
 
-			createdContent.erase(it);
+			DestroySlot(targetID & 0xFFFF);
 
 			return true;
 		}
@@ -97,106 +266,266 @@ namespace KalaWindow::Core
 		{
 			if (!targetPtr) return false;
 
-			//skip early if target ptr wasnt even found from runtime content vector
-			if (find(runtimeContent.begin(),
-				runtimeContent.end(),
-				targetPtr)
-				== runtimeContent.end())
-			{
-				return false;
-			}
-
-			runtimeContent.erase(remove(
-				runtimeContent.begin(),
-				runtimeContent.end(),
-				targetPtr),
-				runtimeContent.end());
+			u32 targetID = targetPtr->GetID();
+			if (GetContent(targetID) != targetPtr) return false;
 
-			if (createdContent.contains(targetPtr->GetID()))
-			{
-				createdContent.erase(targetPtr->GetID());
-			}
+			DestroySlot(targetID & 0xFFFF);
 
 			return true;
 		}
 
 		static inline void RemoveAllContent()
 		{
-			createdContent.clear();
+			for (u16 index : denseSlots)
+			{
+				Slot& slot = SlotAt(index);
+
+				u16 generation = StateGeneration(slot.state.load(memory_order_relaxed));
+				slot.state.store(MakeState(NextGeneration(generation), false), memory_order_seq_cst);
+			}
+
+			KalaWindowRegistryReadGuard::WaitForReaders();
+
+			//destroyed while still listed, same as before this was a slot-map,
+			//so the last destructor does not see an empty registry mid-teardown
+			for (u16 index : denseSlots)
+			{
+				Slot& slot = SlotAt(index);
+
+				slot.Get()->~T();
+				slot.windowID = 0;
+				slot.nextFree = freeHead;
+				freeHead = index;
+			}
+
 			runtimeContent.clear();
+			denseSlots.clear();
+			hotContent.clear();
+			windowContent.clear();
 		}
-		
+
 		//
 		// WINDOW-RELATED ACTIONS
 		//
-		
-		//Returns true if the window owns the ID
-		//Requires target class inside createdContent and runtimeContent
-		//to have the 'u32 GetWindowID()' function.
-		//Should not be used for externally created registries
-		//because the Window class does not accept new IDs
-		template<typename U = T>
-			requires requires(U& u) { u.GetWindowID(); }
+
+		//Returns true if the window owns the ID,
+		//only objects added with a window ID have an owner
 		static inline bool IsOwner(
 			u32 windowID,
 			u32 targetID)
 		{
-			auto it = createdContent.find(targetID);
-			if (it == createdContent.end()) return false;
+			Slot* slot = GetSlot(targetID);
 
-			return it->second
-				&& it->second->GetWindowID() == windowID;
+			return slot
+				&& windowID != 0
+				&& slot->windowID == windowID;
 		}
-			
-		//Get all content as non-owning pointers by window ID from containers.
-		//Requires target class inside createdContent and runtimeContent
-		//to have the 'u32 GetWindowID()' function.
-		//Should not be used for externally created registries
-		//because the Window class does not accept new IDs
-		template<typename U = T>
-			requires requires(U& u) { u.GetWindowID(); }
-		static inline vector<T*> GetAllWindowContent(u32 windowID)
+
+		//Get all content owned by this window as non-owning pointers,
+		//valid until content of this window is added or removed
+		static inline span<T* const> GetAllWindowContent(u32 windowID)
+		{
+			auto it = windowContent.find(windowID);
+			if (it == windowContent.end()) return {};
+
+			return it->second.content;
+		}
+
+		//Remove all content owned by this window
+		static inline void RemoveAllWindowContent(u32 windowID)
+		{
+			//each removal pops from the back of this window's list until it is erased
+			while (true)
+			{
+				auto it = windowContent.find(windowID);
+				if (it == windowContent.end()) return;
+
+				DestroySlot(it->second.slots.back());
+			}
+		}
+	private:
+		static constexpr u16 NO_SLOT = 0xFFFF;
+		static constexpr bool HAS_HOT_STATE = !std::is_same_v<HotState, NoHotState>;
+
+		struct Slot
+		{
+			alignas(T) unsigned char storage[sizeof(T)];
+
+			//Generation in the high 16 bits, alive flag in bit 0, 0 means never used.
+			//The only slot field readers on other threads touch
+			atomic<u32> state{};
+
+			u16 denseIndex{};
+			u16 nextFree = NO_SLOT;
+
+			//Owner window and position in its WindowContent, windowID is 0 if it has none
+			u32 windowID{};
+			u16 windowIndex{};
+
+			T* Get() { return std::launder(rcast<T*>(storage)); }
+		};
+		struct Page
+		{
+			array<Slot, REGISTRY_PAGE_SIZE> slots{};
+		};
+		//Pages are published atomically so readers can walk the table while the writer grows it,
+		//they are only freed on shutdown
+		struct PageTable
 		{
-			vector<T*> out{};
+			array<atomic<Page*>, REGISTRY_MAX_PAGES> pages{};
 
-			for (const auto& v : runtimeContent)
+			~PageTable()
 			{
-				if (v->GetWindowID() == windowID) out.push_back(v);
+				for (auto& page : pages) delete page.load(memory_order_relaxed);
 			}
-				
-			return out;
+		};
+		struct WindowContent
+		{
+			vector<T*> content{};
+			//Slot index of each object in content
+			vector<u16> slots{};
+		};
+
+		static inline Slot& SlotAt(u32 index)
+		{
+			return pageTable.pages[index / REGISTRY_PAGE_SIZE]
+				.load(memory_order_relaxed)
+				->slots[index % REGISTRY_PAGE_SIZE];
 		}
 
-		//Remove all content by window ID from containers.
-		//Requires target class inside createdContent and runtimeContent
-		//to have the 'u32 GetWindowID()' function.
-		//Should not be used for externally created registries
-		//because the Window class does not accept new IDs
-		template<typename U = T>
-			requires requires(U& u) { u.GetWindowID(); }
-		static inline void RemoveAllWindowContent(u32 windowID)
+		//Returns the live slot this ID points to, nullptr if the ID is invalid or stale.
+		//Wait-free, only touches atomics so it can run on any thread
+		static inline Slot* GetSlot(u32 targetID)
 		{
-			runtimeContent.erase(remove_if(
-				runtimeContent.begin(),
-				runtimeContent.end(),
-				[&](T* c)
-				{
-					return c && c->GetWindowID() == windowID;
-				}), runtimeContent.end());
-					
-			for (auto it = createdContent.begin(); it != createdContent.end();)
+			u32 index = targetID & 0xFFFF;
+			u16 generation = scast<u16>((targetID >> REGISTRY_GENERATION_SHIFT) & REGISTRY_GENERATION_MASK);
+
+			if (index >= REGISTRY_MAX_SLOTS
+				|| generation == 0
+				|| (targetID >> REGISTRY_TAG_SHIFT) != Tag())
 			{
-				if (it->second->GetWindowID() == windowID)
+				return nullptr;
+			}
+
+			Page* page = pageTable.pages[index / REGISTRY_PAGE_SIZE].load(memory_order_acquire);
+			if (!page) return nullptr;
+
+			Slot& slot = page->slots[index % REGISTRY_PAGE_SIZE];
+
+			//seq_cst pairs with the guard pin and the unlisting store, with acquire both
+			//sides could miss each other and a reader could use a slot that is being destroyed
+			return slot.state.load(memory_order_seq_cst) == MakeState(generation, true)
+				? &slot
+				: nullptr;
+		}
+
+		//Generations start at 1 so no ID is ever 0
+		static inline u16 StateGeneration(u32 state)
+		{
+			u16 generation = scast<u16>(state >> 16);
+			return generation == 0 ? 1 : generation;
+		}
+		static inline u32 MakeState(
+			u16 generation,
+			bool isAlive)
+		{
+			return (scast<u32>(generation) << 16) | (isAlive ? 1u : 0u);
+		}
+
+		//Wraps within 1 - 0xFFE so IDs are never UINT32_MAX
+		static inline u16 NextGeneration(u16 generation)
+		{
+			return generation >= REGISTRY_GENERATION_MASK - 1
+				? 1
+				: scast<u16>(generation + 1);
+		}
+
+		//Tag of this registry in the top bits of its IDs, 1 - REGISTRY_MAX_TAGS
+		static inline u32 Tag()
+		{
+			static const u32 tag = nextRegistryTag.fetch_add(1, memory_order_relaxed) % REGISTRY_MAX_TAGS + 1;
+			return tag;
+		}
+		static inline u32 MakeID(
+			u16 generation,
+			u32 index)
+		{
+			return (Tag() << REGISTRY_TAG_SHIFT)
+				| (scast<u32>(generation) << REGISTRY_GENERATION_SHIFT)
+				| index;
+		}
+
+		static inline void DestroySlot(u32 index)
+		{
+			Slot& slot = SlotAt(index);
+
+			//unlisted before destruction because destructors check
+			//for an empty registry to detect the last object
+			u16 denseIndex = slot.denseIndex;
+			u16 lastIndex = scast<u16>(runtimeContent.size() - 1);
+
+			if (denseIndex != lastIndex)
+			{
+				runtimeContent[denseIndex] = runtimeContent[lastIndex];
+				denseSlots[denseIndex] = denseSlots[lastIndex];
+				if constexpr (HAS_HOT_STATE) hotContent[denseIndex] = hotContent[lastIndex];
+				SlotAt(denseSlots[denseIndex]).denseIndex = denseIndex;
+			}
+
+			runtimeContent.pop_back();
+			denseSlots.pop_back();
+			if constexpr (HAS_HOT_STATE) hotContent.pop_back();
+
+			if (slot.windowID != 0)
+			{
+				auto it = windowContent.find(slot.windowID);
+				WindowContent& wc = it->second;
+
+				u16 windowIndex = slot.windowIndex;
+				u16 lastWindowIndex = scast<u16>(wc.content.size() - 1);
+
+				if (windowIndex != lastWindowIndex)
 				{
-					it = createdContent.erase(it);
+					wc.content[windowIndex] = wc.content[lastWindowIndex];
+					wc.slots[windowIndex] = wc.slots[lastWindowIndex];
+					SlotAt(wc.slots[windowIndex]).windowIndex = windowIndex;
 				}
-				else ++it;
+
+				wc.content.pop_back();
+				wc.slots.pop_back();
+
+				if (wc.content.empty()) windowContent.erase(it);
+
+				slot.windowID = 0;
 			}
+
+			//the slot stays dead with a new generation until the
+			//destructor returns, in case it looks itself up again
+			u16 generation = StateGeneration(slot.state.load(memory_order_relaxed));
+			slot.state.store(MakeState(NextGeneration(generation), false), memory_order_seq_cst);
+
+			//readers that found this object before it was unlisted may still be using it
+			KalaWindowRegistryReadGuard::WaitForReaders();
+
+			slot.Get()->~T();
+
+			slot.nextFree = freeHead;
+			freeHead = scast<u16>(index);
 		}
-	private:
-		//Owner registry with ID as key
-		static inline unordered_map<u32, unique_ptr<T>> createdContent{};
-		//Runtime non-owning pointers
+
+		//Fixed page table, pages are allocated on first use and never move
+		static inline PageTable pageTable{};
+		static inline u32 slotCount{};
+		static inline u16 freeHead = NO_SLOT;
+
+		//Dense non-owning pointers for iteration
 		static inline vector<T*> runtimeContent{};
+		//Slot index of each object in runtimeContent
+		static inline vector<u16> denseSlots{};
+		//Hot state of each object in runtimeContent, always empty without T::HotState
+		static inline vector<HotState> hotContent{};
+
+		//Content of each window by window ID, windows without content have no entry
+		static inline unordered_map<u32, WindowContent> windowContent{};
 	};
-}
\ No newline at end of file
+}
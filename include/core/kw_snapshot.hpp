@@ -0,0 +1,105 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <array>
+
+#include "core_utils.hpp"
+#include "math_utils.hpp"
+#include "key_standards.hpp"
+
+namespace KalaWindow::Graphics
+{
+	class ProcessWindow;
+}
+
+namespace KalaWindow::Core
+{
+	using std::array;
+
+	using KalaHeaders::KalaMath::vec2;
+	using KalaHeaders::KalaKeyStandards::keyboardButtons;
+	using KalaHeaders::KalaKeyStandards::mouseButtons;
+
+	class Input;
+
+	//How many windows can be stored in a single frame snapshot,
+	//windows past this limit are left out of the snapshot
+	static constexpr u32 MAX_SNAPSHOT_WINDOWS = 32;
+
+	struct LIB_API WindowSnapshot
+	{
+		u32 windowID{};
+		u32 inputID{};
+
+		vec2 size{};
+
+		bool isIdle{};
+		bool isFocused{};
+		bool isHovered{};
+		bool isMinimized{};
+		bool isVisible{};
+		bool isResizing{};
+	};
+
+	struct LIB_API InputSnapshot
+	{
+		array<bool, keyboardButtons.size()> keyDown{};
+		array<bool, keyboardButtons.size()> keyPressed{};
+		array<bool, keyboardButtons.size()> keyReleased{};
+
+		array<bool, mouseButtons.size()> mouseDown{};
+		array<bool, mouseButtons.size()> mousePressed{};
+		array<bool, mouseButtons.size()> mouseReleased{};
+		array<bool, mouseButtons.size()> mouseDoubleClicked{};
+
+		vec2 mousePos{};
+		vec2 mouseDelta{};
+		vec2 rawMouseDelta{};
+
+		f32 mouseWheelDelta{};
+
+		bool isMouseVisible{};
+		bool isMouseLocked{};
+	};
+
+	//Plain copy of every window and input state at the end of a single ProcessWindow::Update call
+	struct LIB_API FrameSnapshot
+	{
+		u64 frameIndex{};
+		u32 windowCount{};
+
+		array<WindowSnapshot, MAX_SNAPSHOT_WINDOWS> windows{};
+		//Input state of the window at the same index in windows
+		array<InputSnapshot, MAX_SNAPSHOT_WINDOWS> inputs{};
+
+		//Returns the state of the window with this ID, nullptr if it was not captured
+		const WindowSnapshot* GetWindow(u32 windowID) const;
+		//Returns the input state of the window with this ID, nullptr if it was not captured
+		const InputSnapshot* GetInput(u32 windowID) const;
+	};
+
+	//Triple-buffered window and input state for render, simulation and job threads.
+	//Only the main thread writes it at the end of ProcessWindow::Update,
+	//any thread can read it without locking and without racing the message loop
+	class LIB_API StateSnapshot
+	{
+	friend class KalaWindow::Graphics::ProcessWindow;
+	public:
+		//Copy the most recently published frame into target, safe to call from any thread.
+		//Returns false if no frame has been published yet
+		static bool Read(FrameSnapshot& target);
+
+		//Returns the index of the most recently published frame, 0 if none has been published yet
+		static u64 GetLatestFrameIndex();
+	private:
+		static void BeginCapture();
+		static void CaptureWindow(
+			const KalaWindow::Graphics::ProcessWindow* window,
+			const Input* input);
+		static void Publish();
+	};
+}
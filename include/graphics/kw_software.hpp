@@ -0,0 +1,147 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include "core_utils.hpp"
+
+#if defined(KLIN_ANY)
+
+#include <array>
+#include <vector>
+
+#include "core/kw_registry.hpp"
+
+namespace KalaWindow::Core
+{
+	class MessageLoop;
+}
+
+namespace KalaWindow::Graphics
+{
+	using std::array;
+	using std::vector;
+
+	using KalaWindow::Core::KalaWindowRegistry;
+
+	struct WindowRect;
+
+	//Layout of the pixels passed to SoftwareFramebuffer::Upload
+	enum class SoftwarePixelFormat : u8
+	{
+		PIXEL_BGRA8, //Same layout as the back buffer, copied as is
+		PIXEL_RGBA8  //Red and blue are swapped while copying
+	};
+
+	//CPU pixel buffer presented straight to a window, for tools that render without a GPU.
+	//Uses MIT-SHM shared memory when the X server supports it so presenting sends no pixels
+	//through the socket, otherwise falls back to XPutImage. Two buffers are kept so drawing
+	//into the back buffer never races the server reading the one presented before it.
+	//With the Present extension frames are presented as pixmaps at the next vblank.
+	//All functions must be called from the main thread
+	class LIB_API SoftwareFramebuffer
+	{
+	friend class ProcessWindow;
+	friend class KalaWindow::Core::MessageLoop;
+	friend struct KalaWindowRegistry<SoftwareFramebuffer>;
+	public:
+		static KalaWindowRegistry<SoftwareFramebuffer>& GetRegistry();
+
+		static bool IsVerboseLoggingEnabled();
+		static void SetVerboseLoggingState(bool newState);
+
+		//Create a framebuffer with the current size of this window
+		static SoftwareFramebuffer* Initialize(u32 windowID);
+
+		u32 GetID() const;
+		u32 GetWindowID() const;
+
+		//Returns true if the buffers live in MIT-SHM shared memory
+		bool IsShared() const;
+		//Returns true if frames go through the Present extension, Present then waits
+		//until the frame before the last one has left the screen, which paces it to the vblank.
+		//Turns off if the server stops freeing pixmaps, presents then go through XShmPutImage
+		bool IsVblankPaced() const;
+
+		//Serial of the last Present, matches PresentTiming::serial of the window once it reaches the screen
+		u32 GetPresentSerial() const;
+
+		u32 GetWidth() const;
+		u32 GetHeight() const;
+		//Bytes per row of the back buffer, can be larger than width * 4
+		u32 GetStride() const;
+
+		//Returns the back buffer, pixels are BGRA8 like the X server uses them.
+		//Valid until the next Present or Resize. Once the window tracks damage with AddDamage,
+		//the back buffer holds the last presented frame and only the damaged areas need to be drawn
+		u32* GetBackBuffer();
+
+		//Copy pixels into the back buffer and convert them to BGRA8,
+		//anything outside the framebuffer is cut off. Stride is in bytes
+		void Upload(
+			const u32* pixels,
+			u32 width,
+			u32 height,
+			u32 stride,
+			SoftwarePixelFormat format);
+
+		//Reallocate both buffers, their contents are lost. Call from the window resize callback
+		bool Resize(
+			u32 width,
+			u32 height);
+
+		//Send the damaged areas of the back buffer to the window, flush it and swap buffers.
+		//Sends the whole back buffer if the window has no damage. If IsVblankPaced is true
+		//the frame is shown at the next vblank and this can wait for the vblank of the frame before
+		void Present();
+
+		void Destroy();
+	private:
+		~SoftwareFramebuffer();
+
+		//One of the two buffers, X11 handles are stored as integers like in WindowData
+		struct SoftwareBuffer
+		{
+			uintptr_t image{};     //XImage*
+			uintptr_t shmInfo{};   //XShmSegmentInfo*, 0 if the buffer is not shared
+			uintptr_t pixmap{};    //Pixmap passed to XPresentPixmap, 0 without Present
+			bool isPixmapShared{}; //The pixmap uses the image memory, nothing is copied into it
+			bool isPixmapStale{};  //The pixmap has none of the image contents yet
+			bool isBusy{};         //The server has not finished reading this buffer yet
+		};
+
+		//Create both buffers at this size, shared if possible
+		bool CreateBuffers(
+			u32 newWidth,
+			u32 newHeight);
+		void DestroyBuffers();
+
+		//Mark the buffer with this segment free again, called from the message loop on ShmCompletion
+		static void HandleCompletion(uintptr_t shmSegment);
+		//Mark the buffer with this pixmap free again, called on PresentIdleNotify
+		static void HandleIdle(uintptr_t pixmap);
+
+		u32 ID{};
+		u32 windowID{};
+
+		uintptr_t gc{};     //GC
+		uintptr_t visual{}; //Visual*
+		int depth{};
+
+		u32 width{};
+		u32 height{};
+
+		bool isShared{};
+		bool isVblankPaced{};
+
+		array<SoftwareBuffer, 2> buffers{};
+		u32 backBufferIndex{};
+
+		u32 presentSerial{};
+		vector<WindowRect> lastPresentRects{}; //Rects of the previous present, the other pixmap does not have them yet
+	};
+}
+
+#endif //KLIN_ANY
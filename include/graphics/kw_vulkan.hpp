@@ -7,6 +7,9 @@
 
 #include <string>
 #include <vector>
+#include <array>
+#include <mutex>
+#include <atomic>
 
 #include "core_utils.hpp"
 
@@ -22,10 +25,14 @@ namespace KalaWindow::Graphics
 {
     using std::string;
     using std::vector;
-    using std::default_delete;
+    using std::array;
+    using std::mutex;
+    using std::atomic;
 
     using KalaWindow::Core::KalaWindowRegistry;
 
+    struct WindowRect;
+
     enum class LIB_API VulkanVersion : u8
     {
         V_1_0 = 0,
@@ -35,10 +42,52 @@ namespace KalaWindow::Graphics
         V_1_4 = 4
     };
 
+    //How many presented frames are kept for latency percentiles
+    static constexpr u32 LATENCY_HISTORY_SIZE = 256;
+    //How many frames can be between simulation start and present at the same time
+    static constexpr u32 MAX_FRAMES_IN_FLIGHT = 8;
+
+    //Timestamps and durations of a single frame, all values are in
+    //KalaWindowCore::GetMonotonicTime nanoseconds, 0 means the stage was not reached
+    struct LIB_API LatencyFrame
+    {
+        u64 frameID{};
+
+        u64 inputTime{};      //OS timestamp of the oldest input event consumed by this frame
+        u64 simulationTime{}; //When the simulation started consuming input
+        u64 submitTime{};     //When rendering commands were submitted
+        u64 presentTime{};    //When the frame was handed to presentation
+
+        u64 inputToSimulation{};
+        u64 simulationToSubmit{};
+        u64 submitToPresent{};
+        u64 inputToPresent{}; //Full input latency, 0 if this frame consumed no input
+    };
+
+    struct LIB_API LatencyPercentiles
+    {
+        u64 p50{};
+        u64 p90{};
+        u64 p99{};
+        u64 max{};
+    };
+
+    //Rolling percentiles over the last LATENCY_HISTORY_SIZE presented frames
+    struct LIB_API LatencyStats
+    {
+        u32 frameCount{};      //Frames used for the stage percentiles
+        u32 inputFrameCount{}; //Frames that consumed input, used for input percentiles
+
+        LatencyPercentiles inputToSimulation{};
+        LatencyPercentiles simulationToSubmit{};
+        LatencyPercentiles submitToPresent{};
+        LatencyPercentiles inputToPresent{};
+    };
+
     class LIB_API VulkanContext
 	{
     friend class ProcessWindow;
-	friend struct default_delete<VulkanContext>;
+	friend struct KalaWindowRegistry<VulkanContext>;
 	public:
         static KalaWindowRegistry<VulkanContext>& GetRegistry();
 
@@ -70,10 +119,42 @@ namespace KalaWindow::Graphics
 
         VkSurfaceKHR GetSurface() const;
 
+        //
+        // LATENCY MARKERS
+        //
+
+        //Call on the main thread after ProcessWindow::Update when the simulation
+        //starts consuming this window's input, returns the ID of the new frame
+        u64 MarkSimulationStart();
+        //Call when the rendering commands of this frame were submitted to the GPU
+        void MarkRenderSubmit(u64 frameID);
+        //Call right after vkQueuePresentKHR returned for this frame
+        void MarkPresent(u64 frameID);
+
+        //Returns the most recently presented frame
+        LatencyFrame GetLastLatencyFrame();
+        //Returns rolling latency percentiles over the recently presented frames
+        LatencyStats GetLatencyStats();
+
+        //
+        // PRESENT REGIONS
+        //
+
+        //Call on the main thread right before vkQueuePresentKHR, returns and clears the window damage.
+        //Empty means the whole image changed. Otherwise enable VK_KHR_incremental_present on the device
+        //and pass these as the VkRectLayerKHR list of a VkPresentRegionKHR, they use the same top left origin
+        vector<WindowRect> GetPresentRegions();
+
         void Destroy();
 	private:
         ~VulkanContext();
 
+        //Returns the in-flight frame with this ID, nullptr if it was already presented or dropped
+        LatencyFrame* GetInFlightFrame(u64 frameID);
+
+        //Returns the ID of the newest frame passed to MarkPresent, safe from any thread
+        u64 GetLastPresentedFrameID() const;
+
         static void Initialize();
 		static bool IsInitialized();
 
@@ -84,5 +165,18 @@ namespace KalaWindow::Graphics
 		u32 windowID{};
 
         VkSurfaceKHR surface{};
+
+        u64 lastFrameID{};
+        array<LatencyFrame, MAX_FRAMES_IN_FLIGHT> inFlightFrames{};
+
+        //Guards in-flight frames and latency history because simulation,
+        //present and stats are usually on different threads
+        mutex latencyMutex{};
+        u32 latencyHistoryCount{};
+        u32 latencyHistoryNext{};
+        array<LatencyFrame, LATENCY_HISTORY_SIZE> latencyHistory{};
+
+        //Written by MarkPresent, read by ProcessWindow::Update without taking latencyMutex
+        atomic<u64> lastPresentedFrameID{};
     };
 }
\ No newline at end of file
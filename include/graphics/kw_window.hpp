@@ -21,6 +21,9 @@
 #endif
 
 #include "core/kw_registry.hpp"
+#if defined(KLIN_ANY)
+#include "graphics/kw_window_global.hpp"
+#endif
 
 namespace KalaWindow::Core
 {
@@ -36,7 +39,6 @@ namespace KalaWindow::Graphics
 	using std::array;
 	using std::pair;
 	using std::filesystem::path;
-	using std::default_delete;
 
 	using KalaHeaders::KalaMath::vec2;
 
@@ -44,6 +46,12 @@ namespace KalaWindow::Graphics
 
 	static constexpr f32 MIN_WINDOW_SIZE = 100.0f;
 	static constexpr f32 MAX_WINDOW_SIZE = 10000.0f;
+	//Default maximum size of a window until SetMaxSize is called, 8K UHD
+	static constexpr f32 DEFAULT_MAX_WINDOW_WIDTH = 7680.0f;
+	static constexpr f32 DEFAULT_MAX_WINDOW_HEIGHT = 4320.0f;
+
+	//How many damage rectangles a window keeps per frame, more are merged into their bounding box
+	static constexpr size_t MAX_DAMAGE_RECTS = 16;
 
 	//Display mode / monitor ownership state
 	enum class WindowMode
@@ -55,7 +63,7 @@ namespace KalaWindow::Graphics
 		WINDOWMODE_BORDERLESS,
 		//Window will go fullscreen and will hide decorations and top bar,
 		//flashes when alt-tabbing and uses full gpu, best for high-performance applications and games,
-		//uses WINDOWMODE_BORDERLESS on x11
+		//on x11 the monitor is switched to the mode set with SetExclusiveDisplayMode while focused
 		WINDOWMODE_EXCLUSIVE
 	};
 
@@ -86,13 +94,133 @@ namespace KalaWindow::Graphics
 	};
 #endif
 
+	//Window state read every frame, kept by the window registry in a dense array
+	//so update passes do not touch the rest of the window
+	struct LIB_API WindowHotState
+	{
+		u32 inputID{};
+
+		bool isIdle{};     //Toggled dynamically by isfocused, isminimized and isvisible checks.
+		bool isHovered{};  //If true, then this window is currently being hovered by the cursor.
+		bool isResizing{}; //If true, then this window is currently being resized
+
+		bool isPendingDestroy{}; //If true, then Destroy was called during Update and teardown waits for the end of Update
+		bool isPooled{};         //If true, then this window is hidden in the window pool and skipped by Update
+		bool isPopup{};          //If true, then this window is override-redirect and never focused, so focus does not make it idle
+
+#if defined(KLIN_ANY)
+		bool isFocused{};
+		bool isVisible{};
+		bool isMinimized{};
+#endif
+
+		//Lets update passes skip empty callbacks without loading them
+		bool hasEarlyUpdateCallback{};
+		bool hasUpdateCallback{};
+		bool hasLateUpdateCallback{};
+	};
+
+#if defined(KLIN_ANY)
+	//What a popup window is used for, tells compositors how to animate and stack it
+	enum class PopupWindowType
+	{
+		POPUPWINDOW_TOOLTIP,       //Hover hint, never takes input
+		POPUPWINDOW_DROPDOWN_MENU, //Menu opened from a menu bar
+		POPUPWINDOW_POPUP_MENU,    //Context menu opened at the cursor
+		POPUPWINDOW_COMBO          //Dropdown list of a combo box
+	};
+
+	//When the compositor is asked to unredirect this window and let it present straight to the screen
+	enum class CompositorBypass
+	{
+		COMPOSITOR_BYPASS_OFF,        //Always composited, even when fullscreen
+		COMPOSITOR_BYPASS_FULLSCREEN, //Bypass while the WM reports the window as fullscreen
+		COMPOSITOR_BYPASS_ALWAYS      //Always ask for bypass, the compositor may still decline when not fullscreen
+	};
+
+	//Compositor timings of one frame from _NET_WM_FRAME_DRAWN and _NET_WM_FRAME_TIMINGS,
+	//times are KalaWindowCore::GetMonotonicTime nanoseconds, 0 means not reported
+	struct CompositorFrameTiming
+	{
+		u64 counterValue{};      //Extended sync counter value of the frame
+		u64 drawnTime{};         //When the compositor drew the frame
+		u64 presentTime{};       //When the frame reached the screen
+		u64 refreshInterval{};   //Refresh interval of the monitor
+		u64 presentationDelay{}; //Time between the compositor starting and presenting a frame
+	};
+
+	//Timings of one present or vblank reported by the Present extension,
+	//times are KalaWindowCore::GetMonotonicTime nanoseconds like LatencyFrame
+	struct PresentTiming
+	{
+		u32 serial{};          //SoftwareFramebuffer::GetPresentSerial of the frame, 0 for vblank requests and other clients
+		u64 msc{};             //Vblank counter of the CRTC the window is on
+		u64 presentTime{};     //When the frame reached the screen
+		u64 refreshInterval{}; //Measured time between two vblanks
+		bool isFlip{};         //The frame was scanned out directly instead of copied
+		bool isSkipped{};      //The frame was replaced by a newer one before reaching the screen
+	};
+#endif
+
+	class ProcessWindow;
+
+	//Rectangle in window client coordinates, top left is 0, 0
+	struct WindowRect
+	{
+		i32 x{};
+		i32 y{};
+		u32 width{};
+		u32 height{};
+	};
+
+	//Describes one window for ProcessWindow::InitializeBatch
+	struct WindowCreateInfo
+	{
+		string title{};
+		vec2 pos = 600;
+		vec2 size = { 800, 600 };
+		ProcessWindow* parentWindow{};
+	};
+
+#if defined(KLIN_ANY)
+	//Window changes requested during a frame, sent together at the end of ProcessWindow::Update
+	//with a single flush. A later request of the same kind replaces the earlier one
+	struct PendingWindowChanges
+	{
+		bool isQueued{}; //If true, then this window is already in the list of windows to send
+
+		bool hasPosition{};
+		vec2 position{};
+
+		bool hasSize{};
+		vec2 size{};
+
+		//Min size, max size and resizable state all share WM_NORMAL_HINTS
+		bool hasSizeHints{};
+
+		bool hasAlwaysOnTop{};
+		bool isAlwaysOnTop{};
+
+		bool hasWindowMode{};
+		WindowMode windowMode{};
+
+		bool hasWindowState{};
+		WindowState windowState{};
+	};
+#endif
+
 	class LIB_API ProcessWindow
 	{
 	friend class KalaWindow::Core::MessageLoop;
 	friend class KalaWindow::Core::Input;
 	friend class VulkanContext;
-	friend struct default_delete<ProcessWindow>;
+#if defined(KLIN_ANY)
+	friend class SoftwareFramebuffer;
+#endif
+	friend struct KalaWindowRegistry<ProcessWindow>;
 	public:
+		using HotState = WindowHotState;
+
 		static KalaWindowRegistry<ProcessWindow>& GetRegistry();
 
 		//Create a new window with a title and at the desired position and size.
@@ -103,6 +231,46 @@ namespace KalaWindow::Graphics
 			vec2 size = { 800, 600 },
 			ProcessWindow* parentWindow = nullptr);
 
+		//Create several windows at once, returned windows match the infos by index
+		//and are nullptr where creation failed. On X11 the requests of all windows are sent
+		//with a single flush instead of waiting on the server for each window,
+		//server errors for them arrive later through each window's error callback
+		static vector<ProcessWindow*> InitializeBatch(vector<WindowCreateInfo>&& infos);
+
+#if defined(KLIN_ANY)
+		//Pre-create hidden windows for short-lived UI like tooltips, context menus and dropdowns,
+		//each with its input and Vulkan surface ready. Pooled windows are override-redirect like popups,
+		//so the WM never decorates, places or focuses them. Pooled windows do not keep the program running
+		static void FillWindowPool(u32 count);
+		//Returns how many windows are waiting in the pool
+		static u32 GetWindowPoolSize();
+		//Take a window from the pool, it is only moved, resized and mapped without taking focus.
+		//Type is only a hint for compositors to stack and animate it. Creates a new pooled window if the pool is empty
+		static ProcessWindow* AcquirePooledWindow(
+			vec2 pos,
+			vec2 size,
+			ProcessWindow* parentWindow = nullptr,
+			PopupWindowType type = PopupWindowType::POPUPWINDOW_TOOLTIP);
+		//Unmap this window and return it to the pool. Its callbacks, input state and children are dropped
+		//and its title, mode, state and size limits go back to the pooled defaults
+		void ReleaseToPool();
+
+		//Create an override-redirect popup that the window manager never sees, so it maps
+		//with a single flush and gets no decorations, reparenting or focus changes.
+		//Offset is relative to the last known position of the parent window,
+		//the popup is destroyed together with its parent
+		static ProcessWindow* InitializePopup(
+			PopupWindowType type,
+			vec2 offset,
+			vec2 size,
+			ProcessWindow* parentWindow);
+		bool IsPopup() const;
+
+		//Returns the monitor this window overlaps the most, nullptr if it overlaps none.
+		//Uses cached geometry only, the pointer stays valid until the monitor layout changes
+		const MonitorData* GetMonitor() const;
+#endif
+
 		//Global update call for process window and input.
 		//  - global early update: what happens BEFORE KalaWindow window logic and input logic
 		//  - global update: what happens IN BETWEEN KalaWindow window logic and input logic
@@ -124,7 +292,7 @@ namespace KalaWindow::Graphics
 		void ClearLastDraggedFiles();
 
 		string GetTitle() const;
-		void SetTitle(string&& newTitle) const;
+		void SetTitle(string&& newTitle);
 
 		//Bring this window to the foreground and make it focused
 		void BringToFocus();
@@ -185,10 +353,67 @@ namespace KalaWindow::Graphics
 		WindowMode GetWindowMode();
 		void SetWindowMode(WindowMode mode);
 
+#if defined(KLIN_ANY)
+		//Resolution and refresh rate the monitor switches to while this window is focused
+		//in WINDOWMODE_EXCLUSIVE, the desktop mode comes back on focus loss, destroy and crash.
+		//Size 0 keeps the monitor resolution, refresh rate 0 picks the rate closest to the current one
+		void SetExclusiveDisplayMode(
+			vec2 size,
+			f32 refreshRate = 0.0f);
+
+		//Written to _NET_WM_BYPASS_COMPOSITOR, unredirected windows skip a frame of compositor latency
+		CompositorBypass GetCompositorBypass() const;
+		void SetCompositorBypass(CompositorBypass newValue);
+		//Returns true if bypass is currently requested from the compositor
+		bool IsCompositorBypassRequested() const;
+
+		//Declare which parts of the window are opaque so the compositor can skip blending them,
+		//replaces the default whole window region. An empty vector marks the whole window as translucent
+		void SetOpaqueRegion(vector<WindowRect>&& rects);
+		//Go back to declaring the whole window opaque, kept in sync with the window size
+		void ResetOpaqueRegion();
+		//Returns true if the opaque region was set with SetOpaqueRegion
+		bool HasCustomOpaqueRegion() const;
+
+		//If true, then _VARIABLE_REFRESH is set while the WM reports this window as fullscreen
+		//so the driver can enable adaptive sync for it
+		bool IsVariableRefreshEnabled() const;
+		void SetVariableRefreshState(bool state);
+		//Returns true if _VARIABLE_REFRESH is currently set on this window
+		bool IsVariableRefreshActive() const;
+
+		//Returns true between finishing a frame and the compositor reporting it drawn,
+		//waiting for this before rendering keeps this window at the compositor's pace.
+		//Stays false until the compositor reported a first frame, and gives up after a short timeout
+		bool IsWaitingForCompositor() const;
+		//Returns the timings of the last frame the compositor reported
+		const CompositorFrameTiming& GetLastCompositorFrameTiming() const;
+
+		//Returns true if the X server reports present timings for this window through the Present extension
+		bool IsPresentTimingAvailable() const;
+		//Returns the timings of the last present or vblank the X server reported,
+		//presents made by the Vulkan driver for this window are reported too
+		const PresentTiming& GetLastPresentTiming() const;
+		//Returns the predicted time of the next vblank, 0 until the first present timing arrives
+		u64 GetNextVblankTime() const;
+		//Ask the X server to report the next vblank as a present timing without presenting anything
+		void RequestVblankTiming();
+#endif
+
 		//Can assign the window state to one of the supported types
 		WindowState GetWindowState() const;
 		void SetWindowState(WindowState state);
 
+		//Mark part of the window as changed since the last present, presents then only send
+		//the damaged areas. Until this or AddFullDamage is first called every present sends the whole window
+		void AddDamage(const WindowRect& rect);
+		//Mark the whole window as changed since the last present
+		void AddFullDamage();
+		//Returns the damaged areas since the last present, including areas the window system asked to redraw
+		const vector<WindowRect>& GetDamage() const;
+		//Returns true if the next present sends the whole window
+		bool IsFullyDamaged() const;
+
 		//What happens before per-window logic
 		//but after global early update
 		void SetEarlyUpdateCallback(function<void()>&& newValue);
@@ -203,33 +428,165 @@ namespace KalaWindow::Graphics
 
 		void SetShutdownCallback(function<void()>&& newValue);
 
+#if defined(KLIN_ANY)
+		//Called during Update for each X11 error caused by a request for this window,
+		//errors that cannot be matched to a window are only logged
+		void SetErrorCallback(function<void(const X11Error&)>&& newValue);
+#endif
+
 		const WindowData& GetWindowData() const;
 
+		//Destroy this window with its children, input and graphics contexts.
+		//When called during Update the window is only marked and skipped for the rest of the frame,
+		//all windows destroyed that frame are then torn down together at the end of Update
 		void Destroy();
+		//Returns true if Destroy was called during this Update and teardown has not run yet
+		bool IsPendingDestroy() const;
 	private:
 		~ProcessWindow();
 
+		//Tear down this window right away
+		void DestroyNow();
+		//Tear down every window that was destroyed during Update
+		static void DestroyPending();
+
 		void UpdateIdleState();
 
-		bool isWindowHovered{}; //If true, then this window is currently being hovered by the cursor.
-		bool isIdle{};          //Toggled dynamically by isfocused, isminimized and isvisible checks.
-		bool isResizing{};      //If true, then this window is currently being resized
+		//Returns this window's entry in the registry hot state array, nullptr while it is being destroyed.
+		//Do not hold on to it across window creation or destruction
+		WindowHotState* GetHotState() const;
+
+		//Add a damage rectangle clipped to the window, used for damage the window system reports too
+		void AppendDamage(const WindowRect& rect);
+		//Returns and clears the damage of this frame, empty means the whole window
+		vector<WindowRect> TakeDamage();
+
+		vector<WindowRect> damageRects{};
+		bool isFullyDamaged{};
+		bool isDamageTracked{}; //False until the app adds damage, every present is a full present until then
 
 		u32 parentID = UINT32_MAX;
 		vector<u32> childIDs{};
 
 #if defined(KLIN_ANY)
+		//Validate and send all requests that create a window, without syncing or flushing
+		static ProcessWindow* SendCreateRequests(
+			string&& title,
+			vec2 pos,
+			vec2 size,
+			ProcessWindow* parentWindow,
+			bool isPooled = false);
+		//Create the input and graphics contexts of a new window
+		void FinishInitialize();
+
+		//Created on first focus or key press so window creation never waits on the input method
+		void CreateInputContext();
+
+		//Hand errors received since the last frame to the windows that caused them
+		static void DispatchErrors();
+
+		//Request serials sent while creating this window, used to match errors to it
+		u64 firstRequestSerial{};
+		u64 lastRequestSerial{};
+
+		function<void(const X11Error&)> errorCallback{};
+
+		//Refresh cached window properties from the X server,
+		//called once at creation and afterwards only from PropertyNotify
+		void UpdateTitle();
+		void UpdateWindowClass();
+		void UpdateResizableState();
+		//Also refreshes the always on top state, all three are read from _NET_WM_STATE
 		void UpdateFullscreenAndMinimizedState();
 
-		bool isFocused{};
-		bool isVisible{};
-		bool isMinimized{};
-		
+		//Returns this window's pending changes and queues the window to be sent at the end of Update
+		PendingWindowChanges& QueueChanges();
+		//Write the pending changes of this window into the X request buffer without flushing
+		void SendPendingChanges();
+		//Write the pending changes of every queued window, Update flushes them afterwards
+		static void SendAllPendingChanges();
+
+		PendingWindowChanges pendingChanges{};
+		bool isUserResizable = true; //Last requested resizable state, written to WM_NORMAL_HINTS
+
+		//Switch the monitor of this window to the exclusive display mode, called when the WM confirms
+		//fullscreen and on focus in. Does nothing unless the window is exclusive, fullscreen and focused
+		void ApplyExclusiveDisplayMode();
+		//Give the monitor back its original mode, called on focus out, fullscreen loss, mode change and destroy
+		void RestoreExclusiveDisplayMode();
+
+		vec2 exclusiveSize{};
+		f32 exclusiveRefreshRate{};
+		uintptr_t exclusiveCrtc{}; //CRTC whose mode this window changed, 0 if none
+
+		//Write _NET_WM_BYPASS_COMPOSITOR if the wanted value changed, the fullscreen mode
+		//follows the state confirmed by the WM in _NET_WM_STATE, not the requested one
+		void UpdateCompositorBypass();
+
+		CompositorBypass compositorBypass = CompositorBypass::COMPOSITOR_BYPASS_FULLSCREEN;
+		u32 compositorBypassValue{}; //Last written value, 0 means no preference like an unset property
+
+		//Write _NET_WM_OPAQUE_REGION, the whole window region is only rewritten when the size changed.
+		//A custom region does not depend on the window geometry so a configure leaves it alone
+		void UpdateOpaqueRegion(bool isConfigure = false);
+
+		vector<WindowRect> opaqueRects{};
+		bool isOpaqueRegionCustom{};
+		vec2 opaqueRegionSize{}; //Window size the whole window region was last written for
+
+		//Set or remove _VARIABLE_REFRESH if the wanted state changed
+		void UpdateVariableRefresh();
+
+		bool isVariableRefreshEnabled{};
+		bool isVariableRefreshActive{};
+
+		//Start a frame on the _NET_WM_SYNC_REQUEST counters, called from VulkanContext::MarkSimulationStart
+		void BeginSyncFrame(u64 frameID);
+		//Finish the sync frame once its latency frame was presented or dropped, tells the WM a frame at the new size is ready
+		void FinishSyncFrame();
+		//Finish the sync frames of every window, Update flushes them afterwards
+		static void SendAllSyncCounters();
+
+		uintptr_t syncCounter{};         //Basic counter, 0 if XSync is not available
+		uintptr_t extendedSyncCounter{}; //Extended counter, odd while a frame is being drawn
+		u64 syncRequestValue{};          //Value of the last _NET_WM_SYNC_REQUEST
+		u64 extendedSyncValue{};
+		bool isSyncRequestPending{};     //Sync request received, its configure has not arrived yet
+		bool isSyncConfigurePending{};   //Configure received, no frame at the new size has started yet
+		bool isSyncFrameResize{};        //The current sync frame answers a sync request
+		u64 syncFrameID{};               //Latency frame ID of the current sync frame, 0 if none
+		u64 syncFrameStart{};            //Monotonic time the current sync frame started at
+		bool hasSyncFrames{};            //False until the first marked frame, sync requests are answered from Update until then
+
+		bool isWaitingForCompositor{};
+		bool hasCompositorFrameDrawn{}; //True once _NET_WM_FRAME_DRAWN arrived, without a compositor it never does
+		u64 compositorWaitStart{};      //Monotonic time the current wait started at
+		CompositorFrameTiming lastCompositorFrameTiming{};
+
+		//Store a PresentCompleteNotify of this window, called from the message loop
+		void HandlePresentComplete(
+			u32 serial,
+			u64 ust,
+			u64 msc,
+			u8 mode);
+
+		uintptr_t presentEventID{}; //Present event context, 0 if Present is not available
+		PresentTiming lastPresentTiming{};
+
+
+		//Cached so getters never wait on an X server round trip
+		string title{};
+		pair<string, string> windowClass{};
+		bool isAlwaysOnTop{};
+		bool isResizable{};
+
 		bool isFullscreen{};
 
-		vec2 pos{};
+		vec2 pos{};         //Root relative position of the client area, also for reparented windows
 		vec2 size{};
 		vec2 outerSize{};
+		vec2 frameOffset{}; //Left and top frame extents, pos minus this is the root relative frame corner
+		bool isReparented{}; //Set from ReparentNotify, real ConfigureNotify events are then relative to the WM frame
 
 		WindowMode windowMode{};
 		WindowState windowState{};
@@ -237,7 +594,7 @@ namespace KalaWindow::Graphics
 		uintptr_t currentDndSource{};
 #endif
 
-		vec2 maxSize = vec2{ 7680, 4320 }; //The maximum size this window can become
+		vec2 maxSize = vec2{ DEFAULT_MAX_WINDOW_WIDTH, DEFAULT_MAX_WINDOW_HEIGHT }; //The maximum size this window can become
 		vec2 minSize = vec2{ 400, 300 };   //The minimum size this window can become
 
 		vec2 oldPos{};  //Stored pre-fullscreen window pos
@@ -252,7 +609,6 @@ namespace KalaWindow::Graphics
 		vec2 draggedFilesPos{};
 		function<void(const vector<path>&, vec2)> draggedFilesCallback{};
 
-		u32 inputID{};
 		u32 graphicsContextID{};
 		
 		WindowData windowData{};
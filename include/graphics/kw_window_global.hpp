@@ -7,15 +7,22 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 #include <filesystem>
 
 #include "core_utils.hpp"
 
+namespace KalaWindow::Core
+{
+	class MessageLoop;
+}
+
 namespace KalaWindow::Graphics
 {
 	using std::string;
 	using std::string_view;
 	using std::vector;
+	using std::function;
 	using std::filesystem::path;
 
 	//Buttons shown on the popup
@@ -73,6 +80,22 @@ namespace KalaWindow::Graphics
 		int xiErrorBase{};
 		int xiOpcode{};
 
+		bool hasRandr{};
+		int randrEventBase{};
+		int randrErrorBase{};
+
+		bool hasSync{};
+		int syncEventBase{};
+		int syncErrorBase{};
+
+		bool hasShm{};
+		bool hasShmPixmaps{}; //Pixmaps can share memory with a software framebuffer
+		int shmOpcode{};
+		int shmEventBase{};
+
+		bool hasPresent{}; //Present and XFixes, both are needed for presenting pixmaps with damage
+		int presentOpcode{};
+
 		uintptr_t atom_utf8{};
 
 		uintptr_t atom_xDndAware{};
@@ -92,6 +115,19 @@ namespace KalaWindow::Graphics
 				
 		uintptr_t atom_net_wm_window_type{};
 		uintptr_t atom_net_wm_window_type_normal{};
+		uintptr_t atom_net_wm_window_type_tooltip{};
+		uintptr_t atom_net_wm_window_type_dropdown_menu{};
+		uintptr_t atom_net_wm_window_type_popup_menu{};
+		uintptr_t atom_net_wm_window_type_combo{};
+
+		uintptr_t atom_net_wm_bypass_compositor{};
+		uintptr_t atom_net_wm_opaque_region{};
+		uintptr_t atom_variable_refresh{};
+
+		uintptr_t atom_net_wm_sync_request{};
+		uintptr_t atom_net_wm_sync_request_counter{};
+		uintptr_t atom_net_wm_frame_drawn{};
+		uintptr_t atom_net_wm_frame_timings{};
 
 		uintptr_t atom_net_wm_name{};
 		uintptr_t atom_net_wm_pid{};
@@ -107,13 +143,44 @@ namespace KalaWindow::Graphics
 		uintptr_t atom_net_wm_state_above{};
 		uintptr_t atom_net_wm_state_skip_taskbar{};
 
+		uintptr_t atom_wm_protocols{};
 		uintptr_t atom_wm_delete{};
 	};
+
+	//One connected output and the CRTC that drives it, cached from XRandR
+	struct MonitorData
+	{
+		uintptr_t output{}; //RROutput, 0 if XRandR is not available
+		uintptr_t crtc{};   //RRCrtc, 0 if XRandR is not available
+		string name{};      //Output name like 'DP-1'
+
+		i32 x{}; //Position in the root window
+		i32 y{};
+		u32 width{};
+		u32 height{};
+
+		f32 refreshRate{}; //Refresh rate of the current mode in Hz, 0 if unknown
+		bool isPrimary{};
+	};
+
+	//X11 protocol error, the server reports these asynchronously
+	//after the request that caused them was already sent
+	struct X11Error
+	{
+		uintptr_t resourceID{}; //XID the failed request was operating on
+		u64 serial{};           //Serial number of the failed request
+		u8 errorCode{};
+		u8 requestCode{};
+		u8 minorCode{};
+		string message{};
+	};
 #endif
 
 	class LIB_API Window_Global
 	{
 	friend class ProcessWindow;
+	friend class SoftwareFramebuffer;
+	friend class KalaWindow::Core::MessageLoop;
 	public:
 		static bool IsVerboseLoggingEnabled();
 		//Toggle verbose logging. If true, then global window context 
@@ -127,6 +194,19 @@ namespace KalaWindow::Graphics
 
 #if defined(KLIN_ANY)
 		static const X11GlobalData& GetGlobalData();
+
+		//Returns the cached monitor layout, it is kept current from XRandR change events
+		//so this never talks to the X server. Falls back to the root window as one monitor without XRandR
+		static const vector<MonitorData>& GetMonitors();
+		//Returns the primary monitor, or the first one if none is marked primary
+		static const MonitorData* GetPrimaryMonitor();
+
+		//Called from the message loop after the monitor layout changed
+		static void SetMonitorsChangedCallback(function<void()>&& newValue);
+
+		//Restore every display mode changed by exclusive windows. The crash handler passes true
+		//to use its own connection because the one of the crashed process can not be trusted
+		static void RestoreAllCrtcModes(bool useNewConnection = false);
 #endif
 
 #if defined(KWIN_ANY)
@@ -175,6 +255,25 @@ namespace KalaWindow::Graphics
 		static bool IsInitialized();
 #if defined(KLIN_ANY)
 		static void Shutdown();
+
+		//Returns and clears all X11 errors received since the last call
+		static vector<X11Error> ConsumeErrors();
+		//Removes the errors caused by this major request code and returns true if there were any,
+		//for probes that sync right after their request
+		static bool ConsumeRequestErrors(int requestCode);
+
+		//Query outputs and CRTCs again, only called at startup and after XRandR change events
+		static void UpdateMonitors();
+
+		//Switch the CRTC to the closest mode with this resolution, refresh rate 0 keeps the current rate.
+		//The original mode is saved the first time the CRTC is changed
+		static bool SetCrtcMode(
+			uintptr_t crtc,
+			u32 width,
+			u32 height,
+			f32 refreshRate);
+		//Restore the saved original mode of this CRTC
+		static void RestoreCrtcMode(uintptr_t crtc);
 #endif
 	};
 }
\ No newline at end of file
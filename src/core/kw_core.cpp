@@ -34,6 +34,7 @@
 
 #include <fstream>
 #include <set>
+#include <chrono>
 
 #include "vulkan/vulkan_core.h"
 
@@ -64,6 +65,9 @@ using std::string_view;
 using std::ifstream;
 using std::set;
 using std::pair;
+using std::chrono::steady_clock;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
 
 #if defined(KWIN_GNU)
 __attribute__((target("xsave")))
@@ -88,6 +92,12 @@ namespace KalaWindow::Core
 	u32 KalaWindowCore::GetGlobalID() { return globalID; }
 	void KalaWindowCore::SetGlobalID(u32 newID) { globalID = newID; }
 
+	u64 KalaWindowCore::GetMonotonicTime()
+	{
+		return scast<u64>(duration_cast<nanoseconds>(
+			steady_clock::now().time_since_epoch()).count());
+	}
+
 	path KalaWindowCore::GetExePath()
 	{
 		path exePath{};
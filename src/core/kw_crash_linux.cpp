@@ -199,6 +199,9 @@ void HandleCrash(
 
     if (pid == 0)
     {
+        //never leave the desktop at the resolution of an exclusive window
+        Window_Global::RestoreAllCrtcModes(true);
+
         if (signal == SIGTRAP)
         {
             string title = !forceCloseTitle.empty()
@@ -0,0 +1,741 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include "core/kw_gamepad.hpp"
+
+#if defined(KLIN_ANY)
+
+#include <linux/input.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <filesystem>
+
+#include "log_utils.hpp"
+
+#include "core/kw_core.hpp"
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+
+using KalaWindow::Core::GamepadButton;
+using KalaWindow::Core::GamepadAxis;
+using KalaWindow::Core::MAX_GAMEPADS;
+using KalaWindow::Core::MAX_NAME_LENGTH;
+using KalaWindow::Core::GAMEPAD_BUTTON_COUNT;
+using KalaWindow::Core::GAMEPAD_AXIS_COUNT;
+
+using std::array;
+using std::atomic;
+using std::thread;
+using std::mutex;
+using std::lock_guard;
+using std::string;
+using std::string_view;
+using std::to_string;
+using std::memory_order_relaxed;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::memory_order_acq_rel;
+using std::filesystem::directory_iterator;
+
+static constexpr const char* INPUT_DIR = "/dev/input";
+//How many evdev events are read from a device per read call
+static constexpr u32 EVENT_BATCH_SIZE = 64;
+
+static_assert(GAMEPAD_BUTTON_COUNT <= 32, "Gamepad buttons are stored as bits in a u32!");
+
+//Written only by the reader thread, read by the main thread
+struct SharedGamepadState
+{
+	atomic<bool> isConnected{};
+	//Changes every time a new device takes this slot, the name is published before it changes
+	atomic<u32> connectionID{};
+
+	atomic<u32> buttonsDown{};
+	//Latched until the next frame so presses shorter than a frame are not lost
+	atomic<u32> buttonsPressed{};
+	atomic<u32> buttonsReleased{};
+
+	array<atomic<f32>, GAMEPAD_AXIS_COUNT> axes{};
+
+	atomic<u64> lastEventTime{};
+
+	//The name is too large to be atomic, only copied while holding nameMutex
+	mutex nameMutex{};
+	array<char, MAX_NAME_LENGTH> name{};
+};
+
+//Latched once per frame from SharedGamepadState, main thread only
+struct FrameGamepadState
+{
+	bool isConnected{};
+	u32 connectionID{};
+
+	u32 buttonsDown{};
+	u32 buttonsPressed{};
+	u32 buttonsReleased{};
+
+	array<f32, GAMEPAD_AXIS_COUNT> axes{};
+
+	u64 lastEventTime{};
+
+	string name{};
+};
+
+struct AxisRange
+{
+	i32 min{};
+	i32 max{};
+	i32 flat{};
+};
+
+//Reader thread only
+struct GamepadDevice
+{
+	int fd = -1;
+	string path{};
+	array<AxisRange, GAMEPAD_AXIS_COUNT> axisRanges{};
+};
+
+static bool isInitialized{};
+static bool isVerboseLoggingEnabled{};
+
+static array<SharedGamepadState, MAX_GAMEPADS> sharedStates{};
+static array<FrameGamepadState, MAX_GAMEPADS> frameStates{};
+static array<GamepadDevice, MAX_GAMEPADS> devices{};
+
+static thread readerThread{};
+static int wakeFD = -1;
+static int inotifyFD = -1;
+static u32 nextConnectionID{};
+
+static constexpr u16 axisCodes[GAMEPAD_AXIS_COUNT] =
+{
+	ABS_X,
+	ABS_Y,
+	ABS_RX,
+	ABS_RY,
+	ABS_Z,
+	ABS_RZ
+};
+
+static bool IsTrigger(u8 axis)
+{
+	return axis == scast<u8>(GamepadAxis::GAMEPAD_LEFT_TRIGGER)
+		|| axis == scast<u8>(GamepadAxis::GAMEPAD_RIGHT_TRIGGER);
+}
+
+//Returns the button bit for this evdev key code, 0 if it is not a gamepad button
+static u32 ToButtonBit(u16 code)
+{
+	auto bit = [](GamepadButton b) { return 1u << scast<u8>(b); };
+
+	switch (code)
+	{
+	case BTN_SOUTH:      return bit(GamepadButton::GAMEPAD_A);
+	case BTN_EAST:       return bit(GamepadButton::GAMEPAD_B);
+	//xpad and most Xbox style drivers report X as BTN_X and Y as BTN_Y
+	case BTN_X:          return bit(GamepadButton::GAMEPAD_X);
+	case BTN_Y:          return bit(GamepadButton::GAMEPAD_Y);
+	case BTN_TL:         return bit(GamepadButton::GAMEPAD_LEFT_BUMPER);
+	case BTN_TR:         return bit(GamepadButton::GAMEPAD_RIGHT_BUMPER);
+	case BTN_SELECT:     return bit(GamepadButton::GAMEPAD_BACK);
+	case BTN_START:      return bit(GamepadButton::GAMEPAD_START);
+	case BTN_MODE:       return bit(GamepadButton::GAMEPAD_GUIDE);
+	case BTN_THUMBL:     return bit(GamepadButton::GAMEPAD_LEFT_STICK);
+	case BTN_THUMBR:     return bit(GamepadButton::GAMEPAD_RIGHT_STICK);
+	case BTN_DPAD_UP:    return bit(GamepadButton::GAMEPAD_DPAD_UP);
+	case BTN_DPAD_DOWN:  return bit(GamepadButton::GAMEPAD_DPAD_DOWN);
+	case BTN_DPAD_LEFT:  return bit(GamepadButton::GAMEPAD_DPAD_LEFT);
+	case BTN_DPAD_RIGHT: return bit(GamepadButton::GAMEPAD_DPAD_RIGHT);
+	default:             return 0;
+	}
+}
+
+static f32 NormalizeAxis(
+	u8 axis,
+	i32 value,
+	const AxisRange& range)
+{
+	if (range.max <= range.min) return 0.0f;
+
+	if (IsTrigger(axis))
+	{
+		if (value - range.min <= range.flat) return 0.0f;
+
+		f32 result = scast<f32>(value - range.min) / scast<f32>(range.max - range.min);
+		return result > 1.0f ? 1.0f : result;
+	}
+
+	f32 center = (scast<f32>(range.min) + scast<f32>(range.max)) * 0.5f;
+	f32 halfRange = (scast<f32>(range.max) - scast<f32>(range.min)) * 0.5f;
+	f32 offset = scast<f32>(value) - center;
+
+	if (offset >= -scast<f32>(range.flat)
+		&& offset <= scast<f32>(range.flat))
+	{
+		return 0.0f;
+	}
+
+	f32 result = offset / halfRange;
+	if (result < -1.0f) return -1.0f;
+	if (result > 1.0f) return 1.0f;
+	return result;
+}
+
+static bool TestBit(
+	const u8* bits,
+	u32 bit)
+{
+	return bits[bit / 8] & (1u << (bit % 8));
+}
+
+static void SetButtons(
+	SharedGamepadState& state,
+	u32 bits,
+	bool isDown)
+{
+	u32 down = state.buttonsDown.load(memory_order_relaxed);
+
+	if (isDown)
+	{
+		u32 changed = bits & ~down;
+		if (changed == 0) return;
+
+		state.buttonsDown.store(down | changed, memory_order_release);
+		state.buttonsPressed.fetch_or(changed, memory_order_release);
+	}
+	else
+	{
+		u32 changed = bits & down;
+		if (changed == 0) return;
+
+		state.buttonsDown.store(down & ~changed, memory_order_release);
+		state.buttonsReleased.fetch_or(changed, memory_order_release);
+	}
+}
+
+//D-pads on most controllers are a hat axis instead of four buttons
+static void SetHat(
+	SharedGamepadState& state,
+	u16 code,
+	i32 value)
+{
+	auto bit = [](GamepadButton b) { return 1u << scast<u8>(b); };
+
+	u32 negative = code == ABS_HAT0X
+		? bit(GamepadButton::GAMEPAD_DPAD_LEFT)
+		: bit(GamepadButton::GAMEPAD_DPAD_UP);
+	u32 positive = code == ABS_HAT0X
+		? bit(GamepadButton::GAMEPAD_DPAD_RIGHT)
+		: bit(GamepadButton::GAMEPAD_DPAD_DOWN);
+
+	SetButtons(state, value < 0 ? negative : 0, true);
+	SetButtons(state, value > 0 ? positive : 0, true);
+	SetButtons(state, value < 0 ? 0 : negative, false);
+	SetButtons(state, value > 0 ? 0 : positive, false);
+}
+
+//Reads the full current device state, used when a device is opened
+//and when the kernel dropped events because the reader fell behind
+static void ResyncDevice(u8 slot)
+{
+	GamepadDevice& device = devices[slot];
+	SharedGamepadState& state = sharedStates[slot];
+
+	array<u8, KEY_MAX / 8 + 1> keyBits{};
+	if (ioctl(device.fd, EVIOCGKEY(keyBits.size()), keyBits.data()) >= 0)
+	{
+		u32 down{};
+		for (u32 code = BTN_MISC; code < KEY_MAX; ++code)
+		{
+			if (TestBit(keyBits.data(), code)) down |= ToButtonBit(scast<u16>(code));
+		}
+
+		SetButtons(state, down, true);
+		SetButtons(state, ~down, false);
+	}
+
+	for (u8 i = 0; i < GAMEPAD_AXIS_COUNT; ++i)
+	{
+		input_absinfo info{};
+		if (ioctl(device.fd, EVIOCGABS(axisCodes[i]), &info) < 0) continue;
+
+		state.axes[i].store(
+			NormalizeAxis(i, info.value, device.axisRanges[i]),
+			memory_order_release);
+	}
+
+	for (u16 code : { scast<u16>(ABS_HAT0X), scast<u16>(ABS_HAT0Y) })
+	{
+		input_absinfo info{};
+		if (ioctl(device.fd, EVIOCGABS(code), &info) < 0) continue;
+
+		SetHat(state, code, info.value);
+	}
+}
+
+static void CloseDevice(u8 slot)
+{
+	GamepadDevice& device = devices[slot];
+	SharedGamepadState& state = sharedStates[slot];
+
+	if (device.fd < 0) return;
+
+	close(device.fd);
+
+	if (isVerboseLoggingEnabled)
+	{
+		Log::Print(
+			"Disconnected gamepad '" + device.path + "' from slot '" + to_string(slot) + "'.",
+			"KW_GAMEPAD",
+			LogType::LOG_INFO);
+	}
+
+	device = {};
+
+	state.isConnected.store(false, memory_order_release);
+
+	SetButtons(state, UINT32_MAX, false);
+	for (auto& axis : state.axes) axis.store(0.0f, memory_order_release);
+}
+
+static void OpenDevice(const string& devicePath)
+{
+	for (const GamepadDevice& d : devices)
+	{
+		if (d.fd >= 0
+			&& d.path == devicePath)
+		{
+			return;
+		}
+	}
+
+	int fd = open(devicePath.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0)
+	{
+		//udev may not have fixed up permissions yet, IN_ATTRIB retries later
+		if (errno == EACCES
+			&& isVerboseLoggingEnabled)
+		{
+			Log::Print(
+				"No permission to open input device '" + devicePath + "'.",
+				"KW_GAMEPAD",
+				LogType::LOG_WARNING);
+		}
+
+		return;
+	}
+
+	array<u8, KEY_MAX / 8 + 1> keyBits{};
+	if (ioctl(fd, EVIOCGBIT(EV_KEY, keyBits.size()), keyBits.data()) < 0
+		|| (!TestBit(keyBits.data(), BTN_GAMEPAD)
+		&& !TestBit(keyBits.data(), BTN_JOYSTICK)))
+	{
+		close(fd);
+		return;
+	}
+
+	u8 slot = MAX_GAMEPADS;
+	for (u8 i = 0; i < MAX_GAMEPADS; ++i)
+	{
+		if (devices[i].fd < 0)
+		{
+			slot = i;
+			break;
+		}
+	}
+
+	if (slot == MAX_GAMEPADS)
+	{
+		Log::Print(
+			"Ignored gamepad '" + devicePath + "' because all "
+			+ to_string(MAX_GAMEPADS) + " gamepad slots are in use!",
+			"KW_GAMEPAD",
+			LogType::LOG_WARNING);
+
+		close(fd);
+		return;
+	}
+
+	//event timestamps default to CLOCK_REALTIME, which can jump
+	int clockID = CLOCK_MONOTONIC;
+	ioctl(fd, EVIOCSCLOCKID, &clockID);
+
+	GamepadDevice& device = devices[slot];
+	SharedGamepadState& state = sharedStates[slot];
+
+	device.fd = fd;
+	device.path = devicePath;
+
+	for (u8 i = 0; i < GAMEPAD_AXIS_COUNT; ++i)
+	{
+		input_absinfo info{};
+		if (ioctl(fd, EVIOCGABS(axisCodes[i]), &info) < 0) continue;
+
+		device.axisRanges[i] =
+		{
+			.min = info.minimum,
+			.max = info.maximum,
+			.flat = info.flat
+		};
+	}
+
+	//read into a local copy first, the ioctl must not run while the main thread waits on the lock
+	array<char, MAX_NAME_LENGTH> name{};
+	if (ioctl(fd, EVIOCGNAME(name.size() - 1), name.data()) < 0)
+	{
+		strncpy(name.data(), "Unknown gamepad", name.size() - 1);
+	}
+
+	{
+		lock_guard lock(state.nameMutex);
+		state.name = name;
+	}
+
+	state.buttonsPressed.store(0, memory_order_relaxed);
+	state.lastEventTime.store(0, memory_order_relaxed);
+
+	ResyncDevice(slot);
+
+	state.connectionID.store(++nextConnectionID, memory_order_release);
+	state.isConnected.store(true, memory_order_release);
+
+	Log::Print(
+		"Connected gamepad '" + string(name.data()) + "' from '"
+		+ devicePath + "' to slot '" + to_string(slot) + "'.",
+		"KW_GAMEPAD",
+		LogType::LOG_SUCCESS);
+}
+
+//Returns false if the device is gone
+static bool ReadDevice(u8 slot)
+{
+	GamepadDevice& device = devices[slot];
+	SharedGamepadState& state = sharedStates[slot];
+
+	array<input_event, EVENT_BATCH_SIZE> events{};
+
+	while (true)
+	{
+		ssize_t bytes = read(device.fd, events.data(), sizeof(events));
+		if (bytes < 0)
+		{
+			if (errno == EAGAIN) return true;
+			if (errno == EINTR) continue;
+
+			return false;
+		}
+
+		size_t count = scast<size_t>(bytes) / sizeof(input_event);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const input_event& e = events[i];
+
+			u64 time =
+				scast<u64>(e.input_event_sec) * 1'000'000'000ull
+				+ scast<u64>(e.input_event_usec) * 1'000ull;
+
+			switch (e.type)
+			{
+			case EV_KEY:
+			{
+				//value 2 is autorepeat
+				if (e.value == 2) break;
+
+				u32 bit = ToButtonBit(e.code);
+				if (bit == 0) break;
+
+				SetButtons(state, bit, e.value != 0);
+				state.lastEventTime.store(time, memory_order_release);
+				break;
+			}
+			case EV_ABS:
+			{
+				if (e.code == ABS_HAT0X
+					|| e.code == ABS_HAT0Y)
+				{
+					SetHat(state, e.code, e.value);
+					state.lastEventTime.store(time, memory_order_release);
+					break;
+				}
+
+				for (u8 a = 0; a < GAMEPAD_AXIS_COUNT; ++a)
+				{
+					if (axisCodes[a] != e.code) continue;
+
+					state.axes[a].store(
+						NormalizeAxis(a, e.value, device.axisRanges[a]),
+						memory_order_release);
+					state.lastEventTime.store(time, memory_order_release);
+					break;
+				}
+				break;
+			}
+			case EV_SYN:
+			{
+				//the kernel buffer overflowed, events up to the next report are incomplete
+				if (e.code == SYN_DROPPED) ResyncDevice(slot);
+				break;
+			}
+			}
+		}
+	}
+}
+
+static void ReadHotplugEvents()
+{
+	alignas(inotify_event) char buffer[4096];
+
+	while (true)
+	{
+		ssize_t bytes = read(inotifyFD, buffer, sizeof(buffer));
+		if (bytes <= 0) return;
+
+		for (char* ptr = buffer; ptr < buffer + bytes; )
+		{
+			const inotify_event* e = rcast<const inotify_event*>(ptr);
+			ptr += sizeof(inotify_event) + e->len;
+
+			if (e->len == 0
+				|| strncmp(e->name, "event", 5) != 0)
+			{
+				continue;
+			}
+
+			string devicePath = string(INPUT_DIR) + "/" + e->name;
+
+			if (e->mask & IN_DELETE)
+			{
+				for (u8 slot = 0; slot < MAX_GAMEPADS; ++slot)
+				{
+					if (devices[slot].path == devicePath) CloseDevice(slot);
+				}
+			}
+			else OpenDevice(devicePath);
+		}
+	}
+}
+
+static void ReaderLoop()
+{
+	while (true)
+	{
+		array<pollfd, MAX_GAMEPADS + 2> fds{};
+		array<u8, MAX_GAMEPADS + 2> slots{};
+		u32 count{};
+
+		fds[count++] = { wakeFD, POLLIN, 0 };
+		fds[count++] = { inotifyFD, POLLIN, 0 };
+
+		for (u8 slot = 0; slot < MAX_GAMEPADS; ++slot)
+		{
+			if (devices[slot].fd < 0) continue;
+
+			slots[count] = slot;
+			fds[count++] = { devices[slot].fd, POLLIN, 0 };
+		}
+
+		if (poll(fds.data(), count, -1) < 0)
+		{
+			if (errno == EINTR) continue;
+			return;
+		}
+
+		if (fds[0].revents) return;
+
+		if (fds[1].revents & POLLIN) ReadHotplugEvents();
+
+		for (u32 i = 2; i < count; ++i)
+		{
+			if (fds[i].revents == 0) continue;
+
+			if ((fds[i].revents & (POLLERR | POLLHUP | POLLNVAL))
+				|| !ReadDevice(slots[i]))
+			{
+				CloseDevice(slots[i]);
+			}
+		}
+	}
+}
+
+namespace KalaWindow::Core
+{
+	bool Gamepad::IsVerboseLoggingEnabled() { return isVerboseLoggingEnabled; }
+	void Gamepad::SetVerboseLoggingState(bool newState) { isVerboseLoggingEnabled = newState; }
+
+	bool Gamepad::Initialize()
+	{
+		if (isInitialized)
+		{
+			Log::Print(
+				"Cannot initialize gamepads more than once!",
+				"KW_GAMEPAD",
+				LogType::LOG_ERROR,
+				2);
+
+			return false;
+		}
+
+		wakeFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		inotifyFD = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+
+		if (wakeFD < 0
+			|| inotifyFD < 0
+			|| inotify_add_watch(inotifyFD, INPUT_DIR, IN_CREATE | IN_ATTRIB | IN_DELETE) < 0)
+		{
+			Log::Print(
+				"Failed to initialize gamepads because '" + string(INPUT_DIR)
+				+ "' could not be watched: " + strerror(errno),
+				"KW_GAMEPAD",
+				LogType::LOG_ERROR,
+				2);
+
+			if (wakeFD >= 0) close(wakeFD);
+			if (inotifyFD >= 0) close(inotifyFD);
+			wakeFD = -1;
+			inotifyFD = -1;
+
+			return false;
+		}
+
+		//the watch is added first so nothing plugged in during this scan is missed
+		std::error_code ec{};
+		for (const auto& entry : directory_iterator(INPUT_DIR, ec))
+		{
+			string name = entry.path().filename().string();
+			if (name.starts_with("event")) OpenDevice(entry.path().string());
+		}
+
+		readerThread = thread(ReaderLoop);
+
+		isInitialized = true;
+
+		Log::Print(
+			"Initialized gamepads!",
+			"KW_GAMEPAD",
+			LogType::LOG_SUCCESS);
+
+		return true;
+	}
+	bool Gamepad::IsInitialized() { return isInitialized; }
+
+	void Gamepad::Shutdown()
+	{
+		if (!isInitialized) return;
+
+		u64 wake = 1;
+		(void)write(wakeFD, &wake, sizeof(wake));
+
+		if (readerThread.joinable()) readerThread.join();
+
+		for (u8 slot = 0; slot < MAX_GAMEPADS; ++slot) CloseDevice(slot);
+
+		close(wakeFD);
+		close(inotifyFD);
+		wakeFD = -1;
+		inotifyFD = -1;
+
+		frameStates = {};
+
+		isInitialized = false;
+	}
+
+	bool Gamepad::IsConnected(u8 slot)
+	{
+		return slot < MAX_GAMEPADS && frameStates[slot].isConnected;
+	}
+	string_view Gamepad::GetName(u8 slot)
+	{
+		if (slot >= MAX_GAMEPADS) return {};
+		return frameStates[slot].name;
+	}
+
+	bool Gamepad::IsButtonHeld(
+		u8 slot,
+		GamepadButton button)
+	{
+		if (slot >= MAX_GAMEPADS) return false;
+		return frameStates[slot].buttonsDown & (1u << scast<u8>(button));
+	}
+	bool Gamepad::IsButtonPressed(
+		u8 slot,
+		GamepadButton button)
+	{
+		if (slot >= MAX_GAMEPADS) return false;
+		return frameStates[slot].buttonsPressed & (1u << scast<u8>(button));
+	}
+	bool Gamepad::IsButtonReleased(
+		u8 slot,
+		GamepadButton button)
+	{
+		if (slot >= MAX_GAMEPADS) return false;
+		return frameStates[slot].buttonsReleased & (1u << scast<u8>(button));
+	}
+
+	f32 Gamepad::GetAxis(
+		u8 slot,
+		GamepadAxis axis)
+	{
+		if (slot >= MAX_GAMEPADS) return 0.0f;
+		return frameStates[slot].axes[scast<u8>(axis)];
+	}
+
+	u64 Gamepad::GetLastEventTime(u8 slot)
+	{
+		if (slot >= MAX_GAMEPADS) return 0;
+		return frameStates[slot].lastEventTime;
+	}
+
+	void Gamepad::Update()
+	{
+		if (!isInitialized) return;
+
+		for (u8 slot = 0; slot < MAX_GAMEPADS; ++slot)
+		{
+			SharedGamepadState& shared = sharedStates[slot];
+			FrameGamepadState& frame = frameStates[slot];
+
+			frame.isConnected = shared.isConnected.load(memory_order_acquire);
+
+			frame.buttonsDown = shared.buttonsDown.load(memory_order_acquire);
+			frame.buttonsPressed = shared.buttonsPressed.exchange(0, memory_order_acq_rel);
+			frame.buttonsReleased = shared.buttonsReleased.exchange(0, memory_order_acq_rel);
+
+			for (u8 a = 0; a < GAMEPAD_AXIS_COUNT; ++a)
+			{
+				frame.axes[a] = shared.axes[a].load(memory_order_acquire);
+			}
+
+			frame.lastEventTime = shared.lastEventTime.load(memory_order_acquire);
+
+			if (!frame.isConnected) continue;
+
+			u32 connectionID = shared.connectionID.load(memory_order_acquire);
+			if (connectionID != frame.connectionID)
+			{
+				//a reconnect during this copy publishes a newer name and connection ID,
+				//the newer ID makes the next frame copy it again
+				lock_guard lock(shared.nameMutex);
+				frame.name = shared.name.data();
+				frame.connectionID = connectionID;
+			}
+		}
+	}
+}
+
+#endif //KLIN_ANY
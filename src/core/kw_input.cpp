@@ -38,6 +38,7 @@ using KalaHeaders::KalaKeyStandards::IndexToMouse;
 
 using KalaWindow::Graphics::ProcessWindow;
 using KalaWindow::Graphics::WindowData;
+using KalaWindow::Graphics::WindowHotState;
 #if defined(KLIN_ANY)
 using KalaWindow::Graphics::X11GlobalData;
 using KalaWindow::Graphics::Window_Global;
@@ -48,6 +49,24 @@ using std::to_string;
 using std::unique_ptr;
 using std::make_unique;
 
+//How many code points of text input fit into a frame before the buffer grows
+static constexpr size_t TEXT_INPUT_RESERVE = 64;
+
+//Furthest into the future the cursor is extrapolated, past this the prediction overshoots more than it helps
+static constexpr u64 MAX_PREDICTION_NS = 50'000'000;
+//If the newest pointer sample is older than this then the pointer has stopped and is not predicted
+static constexpr u64 MOUSE_IDLE_NS = 100'000'000;
+//Time span of recent samples that velocity is measured over
+static constexpr u64 VELOCITY_WINDOW_NS = 24'000'000;
+//Acceleration is noisy and can flip direction between events, so only part of it is trusted
+static constexpr f32 ACCELERATION_DAMPING = 0.5f;
+
+#if defined(KLIN_ANY)
+//How close to the window edge the locked cursor can get, as a fraction
+//of the window size, before it is warped back to the window center
+static constexpr f32 MOUSE_LOCK_EDGE_MARGIN = 0.125f;
+#endif
+
 namespace KalaWindow::Core
 {
 	static KalaWindowRegistry<Input> registry{};
@@ -101,18 +120,28 @@ namespace KalaWindow::Core
 		RegisterRawInputDevices(&rid, 1, sizeof(rid));
 #endif
 
-		u32 newID = KalaWindowCore::GetGlobalID() + 1;
-		KalaWindowCore::SetGlobalID(newID);
+		u32 newID = registry.AddContent(windowID);
+		if (newID == 0)
+		{
+			Log::Print(
+				"Failed to initialize input for window '" + to_string(windowID) + "' because the input registry is full!",
+				"KW_INPUT",
+				LogType::LOG_ERROR,
+				2);
+
+			return nullptr;
+		}
 
-		unique_ptr<Input> newInput = make_unique<Input>();
-		Input* inputPtr = newInput.get();
+		Input* inputPtr = registry.GetContent(newID);
 
 		inputPtr->ID = newID;
 		inputPtr->windowID = windowID;
 
-		w->inputID = newID;
+		//a frame of fast typing or an IME commit fits without reallocating
+		inputPtr->textInput.reserve(TEXT_INPUT_RESERVE);
+		inputPtr->lastLetter.reserve(TEXT_INPUT_RESERVE);
 
-		registry.AddContent(newID, std::move(newInput));
+		if (WindowHotState* hot = w->GetHotState()) hot->inputID = newID;
 
 		Log::Print(
 			"Created new input context '" + to_string(newID) + "' for window '" + to_string(w->GetID()) + "'!",
@@ -126,6 +155,7 @@ namespace KalaWindow::Core
 	u32 Input::GetWindowID() const { return windowID; }
 
 	const string& Input::GetTypedLetter() const { return lastLetter; }
+	span<const u32> Input::GetTextInput() const { return textInput; }
 
 	vector<KeyboardButton> Input::GetPressedKeys()
 	{
@@ -457,6 +487,100 @@ namespace KalaWindow::Core
 	}
 
 	vec2 Input::GetMousePosition() const { return mousePos; }
+	vec2 Input::PredictMousePosition(u64 targetTime) const
+	{
+		if (mouseHistoryCount < 2) return mousePos;
+
+		//returns the sample that is 'age' samples older than the newest one
+		auto sample = [this](u8 age) -> const MouseSample&
+			{
+				u8 index = (mouseHistoryNext + MOUSE_HISTORY_SIZE - 1 - age) % MOUSE_HISTORY_SIZE;
+				return mouseHistory[index];
+			};
+
+		const MouseSample& newest = sample(0);
+
+		u64 now = KalaWindowCore::GetMonotonicTime();
+
+		if (targetTime <= newest.time
+			|| (now > newest.time
+			&& now - newest.time > MOUSE_IDLE_NS))
+		{
+			return mousePos;
+		}
+
+		//finds the first sample at least VELOCITY_WINDOW_NS older than the sample at 'from',
+		//or the oldest one with a different timestamp if the history does not reach that far
+		auto findWindowStart = [&](u8 from) -> u8
+			{
+				u8 found = 0;
+				for (u8 age = from + 1; age < mouseHistoryCount; ++age)
+				{
+					u64 dt = sample(from).time - sample(age).time;
+					if (dt == 0) continue;
+
+					found = age;
+					if (dt >= VELOCITY_WINDOW_NS) break;
+				}
+				return found;
+			};
+
+		auto velocity = [&](u8 newer, u8 older) -> vec2
+			{
+				const MouseSample& a = sample(newer);
+				const MouseSample& b = sample(older);
+				f32 dt = scast<f32>(a.time - b.time) / 1e9f;
+
+				return
+				{
+					(a.pos.x - b.pos.x) / dt,
+					(a.pos.y - b.pos.y) / dt
+				};
+			};
+
+		u8 recentStart = findWindowStart(0);
+		if (recentStart == 0) return mousePos;
+
+		vec2 recentVelocity = velocity(0, recentStart);
+		vec2 acceleration{};
+
+		u8 olderStart = findWindowStart(recentStart);
+		if (olderStart != 0)
+		{
+			vec2 olderVelocity = velocity(recentStart, olderStart);
+
+			//velocities are measured at the midpoints of their windows
+			f32 dt = scast<f32>(
+				(newest.time - sample(olderStart).time) / 2) / 1e9f;
+
+			acceleration =
+			{
+				(recentVelocity.x - olderVelocity.x) / dt * ACCELERATION_DAMPING,
+				(recentVelocity.y - olderVelocity.y) / dt * ACCELERATION_DAMPING
+			};
+		}
+
+		u64 horizonNS = targetTime - newest.time;
+		if (horizonNS > MAX_PREDICTION_NS) horizonNS = MAX_PREDICTION_NS;
+
+		f32 t = scast<f32>(horizonNS) / 1e9f;
+
+		vec2 offset =
+		{
+			recentVelocity.x * t + 0.5f * acceleration.x * t * t,
+			recentVelocity.y * t + 0.5f * acceleration.y * t * t
+		};
+
+		//a decelerating pointer must not be predicted to reverse direction
+		if (offset.x * recentVelocity.x < 0.0f) offset.x = 0.0f;
+		if (offset.y * recentVelocity.y < 0.0f) offset.y = 0.0f;
+
+		return
+		{
+			newest.pos.x + offset.x,
+			newest.pos.y + offset.y
+		};
+	}
 	vec2 Input::GetMouseDelta()
 	{
 		vec2 currMouseDelta = mouseDelta;
@@ -600,6 +724,8 @@ namespace KalaWindow::Core
 		Display* display = ToVar<Display*>(globalData.display);
 		Window window = ToVar<Window>(windowData.window);
 
+		isWarpPending = false;
+
 		if (!state) XUngrabPointer(display, CurrentTime);
 		else
 		{
@@ -635,6 +761,7 @@ namespace KalaWindow::Core
 	void Input::ClearInputEvents(bool clearHeld)
 	{
 		lastLetter.clear();
+		textInput.clear();
 
 		fill(keyPressed.begin(), keyPressed.end(), false);
 		fill(keyReleased.begin(), keyReleased.end(), false);
@@ -646,6 +773,8 @@ namespace KalaWindow::Core
 		{
 			fill(keyDown.begin(), keyDown.end(), false);
 			fill(mouseDown.begin(), mouseDown.end(), false);
+
+			ClearMouseHistory();
 		}
 
 		//always reset mouse wheel delta
@@ -658,7 +787,79 @@ namespace KalaWindow::Core
 		}
 	}
 
-	void Input::SetTypedLetter(string_view letter) { lastLetter = letter; }
+	void Input::AddTextInput(u32 codePoint)
+	{
+		//control characters, surrogates and out of range values are not text
+		if (codePoint < 0x20
+			|| (codePoint >= 0x7F && codePoint < 0xA0)
+			|| (codePoint >= 0xD800 && codePoint <= 0xDFFF)
+			|| codePoint > 0x10FFFF)
+		{
+			return;
+		}
+
+		textInput.push_back(codePoint);
+
+		if (codePoint < 0x80) lastLetter.push_back(scast<char>(codePoint));
+		else if (codePoint < 0x800)
+		{
+			lastLetter.push_back(scast<char>(0xC0 | (codePoint >> 6)));
+			lastLetter.push_back(scast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else if (codePoint < 0x10000)
+		{
+			lastLetter.push_back(scast<char>(0xE0 | (codePoint >> 12)));
+			lastLetter.push_back(scast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			lastLetter.push_back(scast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else
+		{
+			lastLetter.push_back(scast<char>(0xF0 | (codePoint >> 18)));
+			lastLetter.push_back(scast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+			lastLetter.push_back(scast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			lastLetter.push_back(scast<char>(0x80 | (codePoint & 0x3F)));
+		}
+	}
+	void Input::AddTextCommand(u32 command)
+	{
+		if (command != TEXT_INPUT_BACKSPACE
+			&& command != TEXT_INPUT_TAB
+			&& command != TEXT_INPUT_NEWLINE)
+		{
+			return;
+		}
+
+		textInput.push_back(command);
+	}
+
+	void Input::AddTextInputUTF16(u16 codeUnit)
+	{
+		if (codeUnit >= 0xD800
+			&& codeUnit <= 0xDBFF)
+		{
+			pendingHighSurrogate = codeUnit;
+			return;
+		}
+
+		if (codeUnit >= 0xDC00
+			&& codeUnit <= 0xDFFF)
+		{
+			//a low surrogate without its high half is dropped
+			if (pendingHighSurrogate != 0)
+			{
+				AddTextInput(
+					0x10000
+					+ ((scast<u32>(pendingHighSurrogate) - 0xD800) << 10)
+					+ (scast<u32>(codeUnit) - 0xDC00));
+			}
+
+			pendingHighSurrogate = 0;
+			return;
+		}
+
+		pendingHighSurrogate = 0;
+		AddTextInput(codeUnit);
+	}
 
 	void Input::SetKeyState(
 		KeyboardButton key,
@@ -710,10 +911,61 @@ namespace KalaWindow::Core
 		mouseDoubleClicked[index] = isDown;
 	}
 
+	void Input::RecordEventTime(u64 time)
+	{
+		//a timestamp no frame took during the last frame belongs to an idle gap, not to this input
+		if (isEventTimeStale)
+		{
+			pendingEventTime = 0;
+			isEventTimeStale = false;
+		}
+
+		if (pendingEventTime == 0
+			|| time < pendingEventTime)
+		{
+			pendingEventTime = time;
+		}
+	}
+	u64 Input::ConsumeEventTime()
+	{
+		u64 time = pendingEventTime;
+		pendingEventTime = 0;
+		isEventTimeStale = false;
+
+		return time;
+	}
+
+	void Input::AddMouseSample(
+		vec2 pos,
+		u64 time)
+	{
+		//events can arrive with an older timestamp than the newest sample
+		//if the X server and local clocks drift, they would invert velocity
+		if (mouseHistoryCount > 0)
+		{
+			u8 newest = (mouseHistoryNext + MOUSE_HISTORY_SIZE - 1) % MOUSE_HISTORY_SIZE;
+			if (time < mouseHistory[newest].time) time = mouseHistory[newest].time;
+		}
+
+		mouseHistory[mouseHistoryNext] = { pos, time };
+		mouseHistoryNext = (mouseHistoryNext + 1) % MOUSE_HISTORY_SIZE;
+		if (mouseHistoryCount < MOUSE_HISTORY_SIZE) ++mouseHistoryCount;
+	}
+	void Input::ClearMouseHistory()
+	{
+		mouseHistoryNext = 0;
+		mouseHistoryCount = 0;
+	}
+
 	void Input::EndFrameUpdate()
 	{
 		ClearInputEvents();
 
+		//markers may be set after Update, so a timestamp gets one more frame to be consumed.
+		//Without markers it would otherwise report the whole idle time as latency of the next frame
+		if (isEventTimeStale) pendingEventTime = 0;
+		isEventTimeStale = pendingEventTime != 0;
+
 		if (isMouseLocked)
 		{
 			ProcessWindow* w = ProcessWindow::GetRegistry().GetContent(windowID);
@@ -760,14 +1012,33 @@ namespace KalaWindow::Core
 					"Failed to end input frame update because the attached display or window was invalid!");
 			}
 
-			Display* display = ToVar<Display*>(globalData.display);
-			Window window = ToVar<Window>(windowData.window);
+			//relative mode gets its movement from XI2 raw motion and the grab
+			//keeps the pointer inside the window, so the pointer only needs to be
+			//recentered once it drifts near an edge instead of every frame
+			if (isWarpPending) return;
 
 			vec2 windowSize = w->GetSize();
 
+			f32 marginX = windowSize.x * MOUSE_LOCK_EDGE_MARGIN;
+			f32 marginY = windowSize.y * MOUSE_LOCK_EDGE_MARGIN;
+
+			bool isNearEdge =
+				mousePos.x < marginX
+				|| mousePos.y < marginY
+				|| mousePos.x > windowSize.x - marginX
+				|| mousePos.y > windowSize.y - marginY;
+
+			if (!isNearEdge) return;
+
+			Display* display = ToVar<Display*>(globalData.display);
+			Window window = ToVar<Window>(windowData.window);
+
 			int centerX = windowSize.x / 2;
 			int centerY = windowSize.y / 2;
 
+			warpSerial = NextRequest(display);
+			isWarpPending = true;
+
 			XWarpPointer(
 				display,
 				None,
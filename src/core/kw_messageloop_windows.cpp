@@ -49,11 +49,13 @@ using KalaWindow::Graphics::PopupAction;
 using KalaWindow::Graphics::PopupResult;
 using KalaWindow::Graphics::PopupType;
 using KalaWindow::Graphics::WindowData;
+using KalaWindow::Graphics::WindowHotState;
 
 using std::string;
 using std::string_view;
 using std::to_string;
 using std::vector;
+using std::span;
 using std::ostringstream;
 using std::function;
 using std::unordered_map;
@@ -350,9 +352,20 @@ namespace KalaWindow::Core
 				}
 
 				u32 windowID = window->GetID();
-				vector<Input*> inputs = KalaWindowRegistry<Input>::GetAllWindowContent(windowID);
+				span<Input* const> inputs = KalaWindowRegistry<Input>::GetAllWindowContent(windowID);
 				Input* input = inputs.empty() ? nullptr : inputs.front();
 
+				//message time is in a different clock domain, so input latency starts when the message is received
+				if (input
+					&& ((msg.message >= WM_KEYFIRST
+					&& msg.message <= WM_KEYLAST)
+					|| (msg.message >= WM_MOUSEFIRST
+					&& msg.message <= WM_MOUSELAST)
+					|| msg.message == WM_INPUT))
+				{
+					input->RecordEventTime(KalaWindowCore::GetMonotonicTime());
+				}
+
 				/*
 				if (msg.message == 0)
 				{
@@ -388,9 +401,36 @@ namespace KalaWindow::Core
 
 				//typing text
 				case WM_UNICHAR:
+				{
+					//probe from the system asking if WM_UNICHAR is supported
+					if (msg.wParam == UNICODE_NOCHAR) return TRUE;
+
+					u32 codePoint = scast<u32>(msg.wParam);
+
+					if (input) input->AddTextInput(codePoint);
+
+					if (addCharCallback
+						&& codePoint >= 0x20
+						&& codePoint != 0x7F)
+					{
+						addCharCallback(codePoint);
+					}
+
+					return 0; //we handled it
+				}
 				case WM_CHAR:
 				{
-					if (addCharCallback) addCharCallback(scast<u32>(msg.wParam));
+					//characters outside the BMP arrive as two messages, one per surrogate
+					u16 codeUnit = scast<u16>(msg.wParam);
+
+					if (input) input->AddTextInputUTF16(codeUnit);
+
+					if (addCharCallback
+						&& codeUnit >= 0x20
+						&& codeUnit != 0x7F)
+					{
+						addCharCallback(codeUnit);
+					}
 
 					return 0; //we handled it
 				}
@@ -426,12 +466,15 @@ namespace KalaWindow::Core
 						switch (msg.wParam)
 						{
 						case VK_BACK:
+							input->AddTextCommand(TEXT_INPUT_BACKSPACE);
 							if (removeFromBackCallback) removeFromBackCallback();
 							break;
 						case VK_TAB:
+							input->AddTextCommand(TEXT_INPUT_TAB);
 							if (addTabCallback) addTabCallback();
 							break;
 						case VK_RETURN:
+							input->AddTextCommand(TEXT_INPUT_NEWLINE);
 							if (addNewlineCallback) addNewlineCallback();
 							break;
 						}
@@ -509,9 +552,13 @@ namespace KalaWindow::Core
 						input->mousePos = newPos;
 						input->mouseDelta = delta;
 
-						if (!window->isWindowHovered)
+						input->AddMouseSample(newPos, KalaWindowCore::GetMonotonicTime());
+
+						WindowHotState* hot = window->GetHotState();
+						if (hot
+							&& !hot->isHovered)
 						{
-							window->isWindowHovered = true;
+							hot->isHovered = true;
 
 							const WindowData& win = window->GetWindowData();
 							HWND hwnd = ToVar<HWND>(win.window);
@@ -533,7 +580,7 @@ namespace KalaWindow::Core
 				}
 				case WM_MOUSELEAVE:
 				{
-					window->isWindowHovered = false;
+					if (WindowHotState* hot = window->GetHotState()) hot->isHovered = false;
 
 					return DefWindowProc(
 						msg.hwnd,
@@ -1148,6 +1195,16 @@ namespace KalaWindow::Core
 					
 					PAINTSTRUCT ps;
 					BeginPaint(hwnd, &ps);
+
+					//the system lost these contents, the next present has to send them again
+					window->AppendDamage(
+					{
+						scast<i32>(ps.rcPaint.left),
+						scast<i32>(ps.rcPaint.top),
+						scast<u32>(ps.rcPaint.right - ps.rcPaint.left),
+						scast<u32>(ps.rcPaint.bottom - ps.rcPaint.top)
+					});
+
 					EndPaint(hwnd, &ps);
 
 					return 0; //we handled it
@@ -1191,7 +1248,12 @@ namespace KalaWindow::Core
 					}
 					}
 
-					if (window->IsResizable()) window->isResizing = false;
+					WindowHotState* hot = window->GetHotState();
+					if (hot
+						&& window->IsResizable())
+					{
+						hot->isResizing = false;
+					}
 
 					if (window->resizeCallback) window->resizeCallback;
 
@@ -1199,10 +1261,12 @@ namespace KalaWindow::Core
 				}
 				case WM_SIZING:
 				{
-					if (window->IsResizable()
-						&& !window->IsResizing())
+					WindowHotState* hot = window->GetHotState();
+					if (hot
+						&& window->IsResizable()
+						&& !hot->isResizing)
 					{
-						window->isResizing = true;
+						hot->isResizing = true;
 					}
 
 					return 0; //we handled it
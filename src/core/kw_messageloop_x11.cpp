@@ -11,6 +11,9 @@
 #include <X11/Xlib.h>
 #include <X11/extensions/XI2.h>
 #include <X11/extensions/XInput2.h>
+#include <X11/extensions/Xrandr.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xpresent.h>
 #include <X11/keysym.h>
 #include <X11/Xutil.h>
 #include <X11/Xatom.h>
@@ -32,6 +35,7 @@
 #include "core/kw_input.hpp"
 #include "graphics/kw_window_global.hpp"
 #include "graphics/kw_window.hpp"
+#include "graphics/kw_software.hpp"
 
 using KalaHeaders::KalaCore::ToVar;
 using KalaHeaders::KalaCore::FromVar;
@@ -50,8 +54,12 @@ using KalaWindow::Graphics::X11GlobalData;
 using KalaWindow::Graphics::ProcessWindow;
 using KalaWindow::Graphics::KalaWindowRegistry;
 using KalaWindow::Graphics::WindowData;
+using KalaWindow::Graphics::WindowHotState;
+using KalaWindow::Graphics::SoftwareFramebuffer;
+using KalaWindow::Graphics::CompositorFrameTiming;
 
 using std::vector;
+using std::span;
 using std::unordered_map;
 using std::string;
 using std::to_string;
@@ -73,6 +81,31 @@ static u32 lastClickTime[8]{};
 
 static int XRESULT{};
 
+//Server timestamps older than this are treated as not being in our clock domain
+static constexpr u64 MAX_EVENT_AGE_MS = 1000;
+
+//Local X servers stamp input events with CLOCK_MONOTONIC milliseconds truncated to 32 bits,
+//this widens the server time back into KalaWindowCore::GetMonotonicTime nanoseconds
+//and falls back to the time the event was received if the two clocks do not line up
+static u64 ToMonotonicTime(
+    Time serverTime,
+    u64 receiveTime)
+{
+    u64 nowMs = receiveTime / 1000000;
+    u64 eventMs = (nowMs & ~0xFFFFFFFFull) | (scast<u64>(serverTime) & 0xFFFFFFFFull);
+
+    //32-bit server time wrapped between the event and now
+    if (eventMs > nowMs)
+    {
+        if (eventMs < 0x100000000ull) return receiveTime;
+        eventMs -= 0x100000000ull;
+    }
+
+    if (nowMs - eventMs > MAX_EVENT_AGE_MS) return receiveTime;
+
+    return eventMs * 1000000;
+}
+
 static const unordered_map<KeySym, KeyboardButton> XKeyToKeyMap = {
 	// Letters
 	{ XK_a, KeyboardButton::K_A }, { XK_b, KeyboardButton::K_B }, { XK_c, KeyboardButton::K_C }, { XK_d, KeyboardButton::K_D },
@@ -190,11 +223,82 @@ namespace KalaWindow::Core
 
         Display* display = ToVar<Display*>(globalData.display);
 
+        //several XRandR events arrive for one layout change, query the layout once after the pump
+        bool monitorsChanged{};
+
         while (XPending(display))
         {
             XEvent event{};
             XNextEvent(display, &event);
 
+            u64 receiveTime = KalaWindowCore::GetMonotonicTime();
+
+            if (globalData.hasRandr)
+            {
+                if (event.type == globalData.randrEventBase + RRScreenChangeNotify)
+                {
+                    //keeps DisplayWidth and DisplayHeight in sync with the new layout
+                    XRRUpdateConfiguration(&event);
+                    monitorsChanged = true;
+                    continue;
+                }
+                if (event.type == globalData.randrEventBase + RRNotify)
+                {
+                    monitorsChanged = true;
+                    continue;
+                }
+            }
+
+            //the server is done reading a software framebuffer
+            if (globalData.hasShm
+                && event.type == globalData.shmEventBase + ShmCompletion)
+            {
+                XShmCompletionEvent* completion = rcast<XShmCompletionEvent*>(&event);
+                SoftwareFramebuffer::HandleCompletion(FromVar(completion->shmseg));
+
+                continue;
+            }
+
+            //present timings of a window and software framebuffer pixmaps the server is done with
+            if (globalData.hasPresent
+                && event.type == GenericEvent
+                && event.xcookie.extension == globalData.presentOpcode)
+            {
+                if (XGetEventData(display, &event.xcookie))
+                {
+                    if (event.xcookie.evtype == PresentCompleteNotify)
+                    {
+                        XPresentCompleteNotifyEvent* complete = rcast<XPresentCompleteNotifyEvent*>(event.xcookie.data);
+
+                        for (const auto& w : activeWindows)
+                        {
+                            if (!w
+                                || ToVar<Window>(w->GetWindowData().window) != complete->window)
+                            {
+                                continue;
+                            }
+
+                            w->HandlePresentComplete(
+                                complete->serial_number,
+                                complete->ust,
+                                complete->msc,
+                                complete->mode);
+
+                            break;
+                        }
+                    }
+                    else if (event.xcookie.evtype == PresentIdleNotify)
+                    {
+                        XPresentIdleNotifyEvent* idle = rcast<XPresentIdleNotifyEvent*>(event.xcookie.data);
+                        SoftwareFramebuffer::HandleIdle(FromVar(idle->pixmap));
+                    }
+
+                    XFreeEventData(display, &event.xcookie);
+                }
+
+                continue;
+            }
+
             if (event.type == GenericEvent)
             {
                 if (XGetEventData(display, &event.xcookie)
@@ -219,7 +323,7 @@ namespace KalaWindow::Core
 
                             u32 windowID = w->GetID();
 
-                            vector<Input*> inputs = KalaWindowRegistry<Input>::GetAllWindowContent(windowID);
+                            span<Input* const> inputs = KalaWindowRegistry<Input>::GetAllWindowContent(windowID);
                             Input* input = inputs.empty() ? nullptr : inputs.front();
 
                             if (!input) continue;
@@ -227,6 +331,8 @@ namespace KalaWindow::Core
                             input->rawMouseDelta.x += (f32)dx;
                             input->rawMouseDelta.y += (f32)dy;
 
+                            input->RecordEventTime(ToMonotonicTime(raw->time, receiveTime));
+
                             if (Input::IsVerboseLoggingEnabled())
                             {
                                 Log::Print(
@@ -243,6 +349,8 @@ namespace KalaWindow::Core
 
             Atom atom_wm_delete = ToVar<Atom>(globalData.atom_wm_delete);
             Atom atom_net_wm_state = ToVar<Atom>(globalData.atom_net_wm_state);
+            Atom atom_net_wm_name = ToVar<Atom>(globalData.atom_net_wm_name);
+            Atom atom_net_wm_allowed_actions = ToVar<Atom>(globalData.atom_net_wm_allowed_actions);
 
             Window target = event.xany.window;
 
@@ -269,7 +377,7 @@ namespace KalaWindow::Core
                 if (target != window) continue;
 
                 u32 windowID = w->GetID();
-                vector<Input*> inputs = KalaWindowRegistry<Input>::GetAllWindowContent(windowID);
+                span<Input* const> inputs = KalaWindowRegistry<Input>::GetAllWindowContent(windowID);
                 Input* input = inputs.empty() ? nullptr : inputs.front();
 
                 if (!input) continue;
@@ -280,12 +388,45 @@ namespace KalaWindow::Core
                 {
                     case ConfigureNotify:
                     {
-                        w->pos = vec2(event.xconfigure.x, event.xconfigure.y);
+                        vec2 oldSize = w->size;
+
+                        //real events of a reparented window are relative to the WM frame and keep the
+                        //last position, the WM sends a synthetic one relative to the root after every move
+                        //(ICCCM 4.1.5). Popups and windows without a WM frame are children of the root
+                        if (event.xconfigure.send_event
+                            || w->IsPopup()
+                            || !w->isReparented)
+                        {
+                            w->pos = vec2(event.xconfigure.x, event.xconfigure.y);
+                        }
+
                         w->size = kclamp(
                             vec2(event.xconfigure.width, event.xconfigure.height),
                             w->minSize,
                             w->maxSize);
 
+                        //old damage was measured against the old size, the whole window is new now
+                        if (!isnear(oldSize, w->size)) w->isFullyDamaged = true;
+
+                        w->UpdateOpaqueRegion(true);
+
+                        //the next frame is drawn at this size, that is the one the WM waits for
+                        if (w->isSyncRequestPending)
+                        {
+                            w->isSyncRequestPending = false;
+                            w->isSyncConfigurePending = true;
+                        }
+
+                        //popups have no frame and querying one would cost a round trip per move
+                        if (w->IsPopup())
+                        {
+                            w->outerSize = w->size;
+                            w->frameOffset = vec2{};
+
+                            if (w->resizeCallback) w->resizeCallback();
+                            break;
+                        }
+
                         Atom netFrameExtents = ToVar<Atom>(globalData.atom_net_frame_extents);
                         
                         Atom actualType{};
@@ -319,6 +460,7 @@ namespace KalaWindow::Core
                             w->outerSize = vec2(
                                 w->size.x + extents[0] + extents[1],
                                 w->size.y + extents[2] + extents[3]);
+                            w->frameOffset = vec2(extents[0], extents[2]);
                             XFree(extents);
                         }
 
@@ -469,7 +611,19 @@ namespace KalaWindow::Core
                         break;
                     }
                     case SelectionRequest: break;
-                    case Expose: break;
+                    case Expose:
+                    {
+                        //the server lost these contents, the next present has to send them again
+                        w->AppendDamage(
+                        {
+                            event.xexpose.x,
+                            event.xexpose.y,
+                            scast<u32>(event.xexpose.width),
+                            scast<u32>(event.xexpose.height)
+                        });
+
+                        break;
+                    }
 
                     case ClientMessage:
                     {
@@ -488,9 +642,75 @@ namespace KalaWindow::Core
                             if (name) XFree(name);
                         }
 
-                        if ((Atom)event.xclient.data.l[0] == atom_wm_delete)
+                        Atom wmProtocols = ToVar<Atom>(globalData.atom_wm_protocols);
+                        Atom netWmSyncRequest = ToVar<Atom>(globalData.atom_net_wm_sync_request);
+                        Atom netWmFrameDrawn = ToVar<Atom>(globalData.atom_net_wm_frame_drawn);
+                        Atom netWmFrameTimings = ToVar<Atom>(globalData.atom_net_wm_frame_timings);
+
+                        //only WM_PROTOCOLS carries a protocol atom in l[0], other messages
+                        //put counter values or window IDs there that can equal any atom
+                        if (event.xclient.message_type == wmProtocols)
+                        {
+                            Atom protocol = (Atom)event.xclient.data.l[0];
+
+                            if (protocol == atom_wm_delete)
+                            {
+                                w->Destroy();
+                                continue;
+                            }
+
+                            //sent right before the ConfigureNotify of a resize step
+                            if (protocol == netWmSyncRequest)
+                            {
+                                w->syncRequestValue =
+                                    scast<u64>(scast<u32>(event.xclient.data.l[2]))
+                                    | (scast<u64>(scast<u32>(event.xclient.data.l[3])) << 32);
+                                w->isSyncRequestPending = true;
+                            }
+
+                            continue;
+                        }
+
+                        //the compositor sends microseconds of the same monotonic clock
+                        if (event.xclient.message_type == netWmFrameDrawn)
                         {
-                            w->Destroy();
+                            u64 counterValue =
+                                scast<u64>(scast<u32>(event.xclient.data.l[0]))
+                                | (scast<u64>(scast<u32>(event.xclient.data.l[1])) << 32);
+                            u64 drawnTime =
+                                scast<u64>(scast<u32>(event.xclient.data.l[2]))
+                                | (scast<u64>(scast<u32>(event.xclient.data.l[3])) << 32);
+
+                            CompositorFrameTiming& timing = w->lastCompositorFrameTiming;
+                            timing = {};
+                            timing.counterValue = counterValue;
+                            timing.drawnTime = drawnTime * 1000;
+
+                            w->hasCompositorFrameDrawn = true;
+                            if (counterValue >= w->extendedSyncValue) w->isWaitingForCompositor = false;
+
+                            continue;
+                        }
+                        if (event.xclient.message_type == netWmFrameTimings)
+                        {
+                            u64 counterValue =
+                                scast<u64>(scast<u32>(event.xclient.data.l[0]))
+                                | (scast<u64>(scast<u32>(event.xclient.data.l[1])) << 32);
+
+                            CompositorFrameTiming& timing = w->lastCompositorFrameTiming;
+                            if (counterValue != timing.counterValue) continue;
+
+                            //0x80000000 means the presentation time is unknown
+                            i32 presentOffset = scast<i32>(event.xclient.data.l[2]);
+                            if (presentOffset != INT32_MIN
+                                && timing.drawnTime != 0)
+                            {
+                                timing.presentTime = timing.drawnTime + scast<i64>(presentOffset) * 1000;
+                            }
+
+                            timing.refreshInterval = scast<u64>(scast<u32>(event.xclient.data.l[3])) * 1000;
+                            timing.presentationDelay = scast<u64>(scast<u32>(event.xclient.data.l[4])) * 1000;
+
                             continue;
                         }
 
@@ -596,54 +816,78 @@ namespace KalaWindow::Core
                     }
                     case DestroyNotify: break;
 
+                    //keep cached window properties current so their getters never query the server,
+                    //deleted properties are refreshed too since that also changes their value
                     case PropertyNotify:
                     {
-                        if (event.xproperty.atom == atom_net_wm_state
-                            && event.xproperty.state == PropertyNewValue)
-                        {
-                            w->UpdateFullscreenAndMinimizedState();
-                        }
+                        Atom atom = event.xproperty.atom;
+
+                        if (atom == atom_net_wm_state) w->UpdateFullscreenAndMinimizedState();
+                        else if (atom == atom_net_wm_name) w->UpdateTitle();
+                        else if (atom == XA_WM_CLASS) w->UpdateWindowClass();
+                        else if (atom == atom_net_wm_allowed_actions) w->UpdateResizableState();
 
                         break;
                     }
 
                     case FocusIn:
                     {
-                        w->isFocused = true;
+                        if (WindowHotState* hot = w->GetHotState()) hot->isFocused = true;
+
+                        if (!xic)
+                        {
+                            w->CreateInputContext();
+                            xic = ToVar<XIC>(w->GetWindowData().xic);
+                        }
                         if (xic) XSetICFocus(xic);
 
+                        //grabs from menus and popups are not a real focus change
+                        if (event.xfocus.mode == NotifyNormal) w->ApplyExclusiveDisplayMode();
+
                         break;
                     }
                     case FocusOut:
                     {
-                        w->isFocused = false;
+                        if (WindowHotState* hot = w->GetHotState()) hot->isFocused = false;
                         if (xic) XUnsetICFocus(xic);
 
+                        //alt-tab must never leave the desktop at the exclusive resolution
+                        if (event.xfocus.mode == NotifyNormal) w->RestoreExclusiveDisplayMode();
+
                         break;
                     }
 
                     case MapNotify:
                     {   
-                        w->isVisible = true;
+                        if (WindowHotState* hot = w->GetHotState()) hot->isVisible = true;
 
                         break;
                     }
                     case UnmapNotify:
                     {   
-                        w->isVisible = false;
+                        if (WindowHotState* hot = w->GetHotState()) hot->isVisible = false;
+
+                        break;
+                    }
+
+                    case ReparentNotify:
+                    {
+                        //back under the root the coordinates are root relative again, like after a WM exit
+                        w->isReparented = event.xreparent.parent != ToVar<Window>(globalData.window_root);
+                        if (!w->isReparented) w->pos = vec2(event.xreparent.x, event.xreparent.y);
 
                         break;
                     }
 
                     case EnterNotify:
                     {
-                        w->isWindowHovered = true;
+                        if (WindowHotState* hot = w->GetHotState()) hot->isHovered = true;
 
                         break;
                     }
                     case LeaveNotify:
                     {
-                        w->isWindowHovered = false;
+                        if (WindowHotState* hot = w->GetHotState()) hot->isHovered = false;
                         
                         break;
                     }
@@ -651,16 +895,55 @@ namespace KalaWindow::Core
                     case KeyPress:
                     {
                         KeySym ks{};
-                        char buffer[32]{};
+                        char stackBuffer[64]{};
+                        char* buffer = stackBuffer;
                         int status{};
+                        int len{};
 
-                        int len = Xutf8LookupString(
-                            xic,
-                            &event.xkey,
-                            buffer,
-                            sizeof(buffer),
-                            &ks,
-                            &status);
+                        if (!xic)
+                        {
+                            w->CreateInputContext();
+                            xic = ToVar<XIC>(w->GetWindowData().xic);
+                        }
+
+                        if (xic)
+                        {
+                            len = Xutf8LookupString(
+                                xic,
+                                &event.xkey,
+                                buffer,
+                                sizeof(stackBuffer),
+                                &ks,
+                                &status);
+                        }
+                        else
+                        {
+                            //no input method, only single byte text is available
+                            len = XLookupString(
+                                &event.xkey,
+                                buffer,
+                                sizeof(stackBuffer),
+                                &ks,
+                                nullptr);
+
+                            status = len > 0 ? XLookupBoth : XLookupKeySym;
+                        }
+
+                        //long IME commits do not fit, the returned length is the size they need
+                        vector<char> heapBuffer{};
+                        if (status == XBufferOverflow)
+                        {
+                            heapBuffer.resize(scast<size_t>(len));
+                            buffer = heapBuffer.data();
+
+                            len = Xutf8LookupString(
+                                xic,
+                                &event.xkey,
+                                buffer,
+                                scast<int>(heapBuffer.size()),
+                                &ks,
+                                &status);
+                        }
 
                         KeyboardButton key = TranslateKeySym(ks);
 
@@ -674,6 +957,8 @@ namespace KalaWindow::Core
 
                         if (input)
                         {
+                            input->RecordEventTime(ToMonotonicTime(event.xkey.time, receiveTime));
+
                             input->SetKeyState(
                                 key, 
                                 true);
@@ -681,48 +966,81 @@ namespace KalaWindow::Core
                             switch (ks)
                             {
                                 case XK_BackSpace:
+                                    input->AddTextCommand(TEXT_INPUT_BACKSPACE);
                                     if (removeFromBackCallback) removeFromBackCallback();
                                     break;
                                 case XK_Tab:
+                                    input->AddTextCommand(TEXT_INPUT_TAB);
                                     if (addTabCallback) addTabCallback();
                                     break;
                                 case XK_Return:
+                                case XK_KP_Enter:
+                                    input->AddTextCommand(TEXT_INPUT_NEWLINE);
                                     if (addNewlineCallback) addNewlineCallback();
                                     break;
                             }
                         }
 
-                        //utf16 text for typing
+                        //utf8 text for typing, or Latin-1 without an input method. Edit keys and ctrl
+                        //combinations also produce control characters here, AddTextInput drops them
+                        //so only the key events above add commands
                         if (len > 0
-                            && addCharCallback)
+                            && (status == XLookupChars
+                            || status == XLookupBoth))
                         {
                             const unsigned char* ptr = (unsigned char*)buffer;
+                            const unsigned char* endPtr = ptr + len;
 
-                            while (ptr < (unsigned char*)buffer + len)
+                            while (ptr < endPtr)
                             {
                                 u32 codePoint{};
+                                u32 extraBytes{};
 
-                                if (*ptr < 0x80) codePoint = *ptr++;
+                                //XLookupString text is Latin-1, every byte is the code point of the same value
+                                if (!xic
+                                    || *ptr < 0x80)
+                                {
+                                    codePoint = *ptr;
+                                }
                                 else if ((*ptr & 0xE0) == 0xC0)
                                 {
-                                    codePoint = (*ptr++ & 0x1F) << 6;
-                                    codePoint |= (*ptr++ & 0x3F);
+                                    codePoint = *ptr & 0x1F;
+                                    extraBytes = 1;
                                 }
                                 else if ((*ptr & 0xF0) == 0xE0)
                                 {
-                                    codePoint = (*ptr++ & 0x0F) << 12;
-                                    codePoint |= (*ptr++ & 0x3F) << 6;
-                                    codePoint |= (*ptr++ & 0x3F);
+                                    codePoint = *ptr & 0x0F;
+                                    extraBytes = 2;
                                 }
                                 else if ((*ptr & 0xF8) == 0xF0)
                                 {
-                                    codePoint = (*ptr++ & 0x07) << 18;
-                                    codePoint |= (*ptr++ & 0x3F) << 12;
-                                    codePoint |= (*ptr++ & 0x3F) << 6;
-                                    codePoint |= (*ptr++ & 0x3F);
+                                    codePoint = *ptr & 0x07;
+                                    extraBytes = 3;
                                 }
+                                else
+                                {
+                                    //stray continuation byte
+                                    ++ptr;
+                                    continue;
+                                }
+
+                                //truncated sequence at the end of the buffer
+                                if (scast<size_t>(endPtr - ptr) <= extraBytes) break;
+
+                                ++ptr;
+                                for (u32 i = 0; i < extraBytes; ++i)
+                                {
+                                    codePoint = (codePoint << 6) | (*ptr++ & 0x3F);
+                                }
+
+                                if (input) input->AddTextInput(codePoint);
 
-                                addCharCallback(codePoint);
+                                if (addCharCallback
+                                    && codePoint >= 0x20
+                                    && codePoint != 0x7F)
+                                {
+                                    addCharCallback(codePoint);
+                                }
                             }
                         }
 
@@ -781,6 +1099,8 @@ namespace KalaWindow::Core
                         u32 btn = event.xbutton.button;
                         u32 time = event.xbutton.time;
 
+                        input->RecordEventTime(ToMonotonicTime(event.xbutton.time, receiveTime));
+
                         bool doubleClick{};
 
                         if (btn <= 7)
@@ -1075,6 +1395,22 @@ namespace KalaWindow::Core
 
                         if (input)
                         {
+                            //the first motion event after a mouse lock recenter warp
+                            //only moves the baseline, it is not real movement
+                            if (input->isWarpPending
+                                && event.xmotion.serial >= input->warpSerial)
+                            {
+                                input->isWarpPending = false;
+                                input->mousePos = newPos;
+                                input->ClearMouseHistory();
+
+                                break;
+                            }
+
+                            u64 eventTime = ToMonotonicTime(event.xmotion.time, receiveTime);
+                            input->RecordEventTime(eventTime);
+                            input->AddMouseSample(newPos, eventTime);
+
                             //get the old position before updating
                             vec2 oldPos = input->GetMousePosition();
 
@@ -1103,6 +1439,8 @@ namespace KalaWindow::Core
                 break;
             }
         }
+
+        if (monitorsChanged) Window_Global::UpdateMonitors();
     }
 }
 
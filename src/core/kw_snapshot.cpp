@@ -0,0 +1,193 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include "core/kw_snapshot.hpp"
+
+#include <atomic>
+
+#include "log_utils.hpp"
+
+#include "core/kw_input.hpp"
+#include "graphics/kw_window.hpp"
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+
+using KalaWindow::Graphics::ProcessWindow;
+
+using std::atomic;
+using std::atomic_thread_fence;
+using std::memory_order_relaxed;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::to_string;
+
+static constexpr u32 SNAPSHOT_SLOT_COUNT = 3;
+static constexpr u32 NO_PUBLISHED_SLOT = UINT32_MAX;
+
+namespace KalaWindow::Core
+{
+	//Odd sequence means the slot is being written to
+	struct SnapshotSlot
+	{
+		atomic<u64> sequence{};
+		FrameSnapshot frame{};
+	};
+
+	static array<SnapshotSlot, SNAPSHOT_SLOT_COUNT> slots{};
+
+	static atomic<u32> latestSlot{ NO_PUBLISHED_SLOT };
+	static atomic<u64> latestFrameIndex{};
+
+	static u32 writeSlot{};
+	static bool isCapturing{};
+	static bool hasWarnedOverflow{};
+
+	const WindowSnapshot* FrameSnapshot::GetWindow(u32 windowID) const
+	{
+		for (u32 i = 0; i < windowCount; ++i)
+		{
+			if (windows[i].windowID == windowID) return &windows[i];
+		}
+
+		return nullptr;
+	}
+	const InputSnapshot* FrameSnapshot::GetInput(u32 windowID) const
+	{
+		for (u32 i = 0; i < windowCount; ++i)
+		{
+			if (windows[i].windowID == windowID) return &inputs[i];
+		}
+
+		return nullptr;
+	}
+
+	bool StateSnapshot::Read(FrameSnapshot& target)
+	{
+		//seqlock read - retries only if the main thread lapped this reader
+		//and started rewriting the same slot while it was being copied
+		while (true)
+		{
+			u32 slot = latestSlot.load(memory_order_acquire);
+			if (slot == NO_PUBLISHED_SLOT) return false;
+
+			const SnapshotSlot& s = slots[slot];
+
+			u64 before = s.sequence.load(memory_order_acquire);
+			if (before & 1) continue;
+
+			target = s.frame;
+
+			atomic_thread_fence(memory_order_acquire);
+
+			u64 after = s.sequence.load(memory_order_relaxed);
+			if (before == after) return true;
+		}
+	}
+
+	u64 StateSnapshot::GetLatestFrameIndex() { return latestFrameIndex.load(memory_order_acquire); }
+
+	void StateSnapshot::BeginCapture()
+	{
+		//never write into the slot readers are currently pointed at
+		u32 latest = latestSlot.load(memory_order_relaxed);
+		writeSlot = latest == NO_PUBLISHED_SLOT
+			? 0
+			: (latest + 1) % SNAPSHOT_SLOT_COUNT;
+
+		SnapshotSlot& s = slots[writeSlot];
+
+		s.sequence.store(s.sequence.load(memory_order_relaxed) + 1, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+
+		s.frame.windowCount = 0;
+
+		isCapturing = true;
+	}
+
+	void StateSnapshot::CaptureWindow(
+		const ProcessWindow* window,
+		const Input* input)
+	{
+		if (!isCapturing
+			|| !window
+			|| !input)
+		{
+			return;
+		}
+
+		FrameSnapshot& frame = slots[writeSlot].frame;
+
+		if (frame.windowCount >= MAX_SNAPSHOT_WINDOWS)
+		{
+			if (!hasWarnedOverflow)
+			{
+				Log::Print(
+					"Window '" + to_string(window->GetID()) + "' and every window after it "
+					"were left out of the frame snapshot because only "
+					+ to_string(MAX_SNAPSHOT_WINDOWS) + " windows fit into it!",
+					"KW_SNAPSHOT",
+					LogType::LOG_WARNING);
+
+				hasWarnedOverflow = true;
+			}
+
+			return;
+		}
+
+		u32 index = frame.windowCount++;
+
+		WindowSnapshot& ws = frame.windows[index];
+
+		ws.windowID = window->GetID();
+		ws.inputID = input->GetID();
+
+		ws.size = window->GetSize();
+
+		ws.isIdle = window->IsIdle();
+		ws.isFocused = window->IsFocused();
+		ws.isHovered = window->IsHovered();
+		ws.isMinimized = window->IsMinimized();
+		ws.isVisible = window->IsVisible();
+		ws.isResizing = window->IsResizing();
+
+		InputSnapshot& is = frame.inputs[index];
+
+		is.keyDown = input->keyDown;
+		is.keyPressed = input->keyPressed;
+		is.keyReleased = input->keyReleased;
+
+		is.mouseDown = input->mouseDown;
+		is.mousePressed = input->mousePressed;
+		is.mouseReleased = input->mouseReleased;
+		is.mouseDoubleClicked = input->mouseDoubleClicked;
+
+		is.mousePos = input->mousePos;
+		is.mouseDelta = input->mouseDelta;
+		is.rawMouseDelta = input->rawMouseDelta;
+
+		is.mouseWheelDelta = input->mouseWheelDelta;
+
+		is.isMouseVisible = input->isMouseVisible;
+		is.isMouseLocked = input->isMouseLocked;
+	}
+
+	void StateSnapshot::Publish()
+	{
+		if (!isCapturing) return;
+
+		SnapshotSlot& s = slots[writeSlot];
+
+		u64 frameIndex = latestFrameIndex.load(memory_order_relaxed) + 1;
+		s.frame.frameIndex = frameIndex;
+
+		s.sequence.store(s.sequence.load(memory_order_relaxed) + 1, memory_order_release);
+
+		latestSlot.store(writeSlot, memory_order_release);
+		latestFrameIndex.store(frameIndex, memory_order_release);
+
+		isCapturing = false;
+	}
+}
@@ -0,0 +1,930 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include "graphics/kw_software.hpp"
+
+#if defined(KLIN_ANY)
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xfixes.h>
+#include <X11/extensions/Xpresent.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <poll.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include "log_utils.hpp"
+
+#include "core/kw_core.hpp"
+#include "graphics/kw_window.hpp"
+#include "graphics/kw_window_global.hpp"
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+
+using KalaHeaders::KalaCore::ToVar;
+using KalaHeaders::KalaCore::FromVar;
+
+using KalaWindow::Core::KalaWindowCore;
+using KalaWindow::Graphics::ProcessWindow;
+using KalaWindow::Graphics::WindowData;
+using KalaWindow::Graphics::Window_Global;
+using KalaWindow::Graphics::X11GlobalData;
+using KalaWindow::Graphics::SoftwarePixelFormat;
+using KalaWindow::Graphics::WindowRect;
+
+using std::string;
+using std::to_string;
+using std::min;
+using std::memcpy;
+using std::malloc;
+using std::free;
+using std::vector;
+
+static bool isVerboseLoggingEnabled{};
+
+//Set after the first failed XShmAttach, usually a remote display, every later framebuffer uses XPutImage
+static bool isShmBroken{};
+
+//Longest wait for PresentIdleNotify, a pixmap is free after two vblanks even at very low refresh rates
+static constexpr u64 PRESENT_IDLE_TIMEOUT = 250'000'000; //250ms in nanoseconds
+
+//Swap red and blue of every pixel, alpha and green stay where they are
+static void SwizzleRow(
+	const u32* src,
+	u32* dst,
+	u32 count)
+{
+	u32 i = 0;
+
+#if defined(__SSE2__)
+	const __m128i maskGA = _mm_set1_epi32(scast<int>(0xFF00FF00));
+	const __m128i maskRB = _mm_set1_epi32(0x00FF00FF);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128(rcast<const __m128i*>(src + i));
+
+		__m128i ga = _mm_and_si128(pixels, maskGA);
+		__m128i rb = _mm_and_si128(pixels, maskRB);
+
+		//red moves up into the blue byte and blue down into the red byte
+		rb = _mm_or_si128(
+			_mm_slli_epi32(rb, 16),
+			_mm_srli_epi32(rb, 16));
+
+		_mm_storeu_si128(
+			rcast<__m128i*>(dst + i),
+			_mm_or_si128(ga, rb));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		u32 pixel = src[i];
+
+		dst[i] =
+			(pixel & 0xFF00FF00)
+			| ((pixel & 0x000000FF) << 16)
+			| ((pixel & 0x00FF0000) >> 16);
+	}
+}
+
+//Matches the PresentIdleNotify events of any window, arg points to the Present opcode
+static Bool IsPresentIdleEvent(
+	Display* display,
+	XEvent* event,
+	XPointer arg)
+{
+	return event->type == GenericEvent
+		&& event->xcookie.extension == *rcast<int*>(arg)
+		&& event->xcookie.evtype == PresentIdleNotify;
+}
+
+//Copy one rect between two images of the same size, both are 32 bits per pixel
+static void CopyRect(
+	const XImage* src,
+	XImage* dst,
+	const WindowRect& rect)
+{
+	size_t offset = scast<size_t>(rect.x) * sizeof(u32);
+	size_t rowSize = scast<size_t>(rect.width) * sizeof(u32);
+
+	for (u32 y = 0; y < rect.height; ++y)
+	{
+		size_t row = scast<size_t>(rect.y) + y;
+
+		memcpy(
+			dst->data + row * dst->bytes_per_line + offset,
+			src->data + row * src->bytes_per_line + offset,
+			rowSize);
+	}
+}
+
+namespace KalaWindow::Graphics
+{
+	static KalaWindowRegistry<SoftwareFramebuffer> registry{};
+
+	KalaWindowRegistry<SoftwareFramebuffer>& SoftwareFramebuffer::GetRegistry() { return registry; }
+
+	bool SoftwareFramebuffer::IsVerboseLoggingEnabled() { return isVerboseLoggingEnabled; }
+	void SoftwareFramebuffer::SetVerboseLoggingState(bool newState) { isVerboseLoggingEnabled = newState; }
+
+	SoftwareFramebuffer* SoftwareFramebuffer::Initialize(u32 windowID)
+	{
+		ProcessWindow* w = ProcessWindow::GetRegistry().GetContent(windowID);
+		if (!w)
+		{
+			Log::Print(
+				"Failed to initialize software framebuffer because its window was invalid!",
+				"KW_SOFTWARE",
+				LogType::LOG_ERROR,
+				2);
+
+			return nullptr;
+		}
+
+		const X11GlobalData& globalData = Window_Global::GetGlobalData();
+		const WindowData& windowData = w->GetWindowData();
+
+		if (!globalData.display
+			|| !windowData.window)
+		{
+			Log::Print(
+				"Failed to initialize software framebuffer "
+				"because the display or window handle for window '" + to_string(windowID) + "' was invalid!",
+				"KW_SOFTWARE",
+				LogType::LOG_ERROR,
+				2);
+
+			return nullptr;
+		}
+
+		Display* display = ToVar<Display*>(globalData.display);
+		Window window = ToVar<Window>(windowData.window);
+
+		//one round trip at creation, the visual decides the pixel layout of every frame
+		XWindowAttributes attributes{};
+		XGetWindowAttributes(display, window, &attributes);
+
+		if (!attributes.visual
+			|| (attributes.depth != 24
+			&& attributes.depth != 32)
+			|| attributes.visual->red_mask != 0x00FF0000
+			|| attributes.visual->green_mask != 0x0000FF00
+			|| attributes.visual->blue_mask != 0x000000FF)
+		{
+			Log::Print(
+				"Failed to initialize software framebuffer for window '" + to_string(windowID)
+				+ "' because its visual is not 24 or 32 bit BGRA!",
+				"KW_SOFTWARE",
+				LogType::LOG_ERROR,
+				2);
+
+			return nullptr;
+		}
+
+		u32 newID = registry.AddContent(windowID);
+		if (newID == 0)
+		{
+			Log::Print(
+				"Failed to initialize software framebuffer for window '" + to_string(windowID)
+				+ "' because the software framebuffer registry is full!",
+				"KW_SOFTWARE",
+				LogType::LOG_ERROR,
+				2);
+
+			return nullptr;
+		}
+
+		SoftwareFramebuffer* fbPtr = registry.GetContent(newID);
+
+		fbPtr->ID = newID;
+		fbPtr->windowID = windowID;
+
+		fbPtr->gc = FromVar(XCreateGC(display, window, 0, nullptr));
+		fbPtr->visual = FromVar(attributes.visual);
+		fbPtr->depth = attributes.depth;
+
+		vec2 size = w->GetSize();
+
+		if (!fbPtr->CreateBuffers(
+			scast<u32>(size.x),
+			scast<u32>(size.y)))
+		{
+			fbPtr->Destroy();
+			return nullptr;
+		}
+
+		Log::Print(
+			"Created new software framebuffer '" + to_string(newID) + "' for window '" + to_string(windowID) + "'"
+			+ (fbPtr->isShared ? " with MIT-SHM" : " without MIT-SHM")
+			+ (fbPtr->isVblankPaced ? " and Present!" : " and without Present!"),
+			"KW_SOFTWARE",
+			LogType::LOG_SUCCESS);
+
+		return fbPtr;
+	}
+
+	u32 SoftwareFramebuffer::GetID() const { return ID; }
+	u32 SoftwareFramebuffer::GetWindowID() const { return windowID; }
+
+	bool SoftwareFramebuffer::IsShared() const { return isShared; }
+	bool SoftwareFramebuffer::IsVblankPaced() const { return isVblankPaced; }
+
+	u32 SoftwareFramebuffer::GetPresentSerial() const { return presentSerial; }
+
+	u32 SoftwareFramebuffer::GetWidth() const { return width; }
+	u32 SoftwareFramebuffer::GetHeight() const { return height; }
+	u32 SoftwareFramebuffer::GetStride() const
+	{
+		XImage* image = ToVar<XImage*>(buffers[backBufferIndex].image);
+		return image ? scast<u32>(image->bytes_per_line) : 0;
+	}
+
+	u32* SoftwareFramebuffer::GetBackBuffer()
+	{
+		XImage* image = ToVar<XImage*>(buffers[backBufferIndex].image);
+		return image ? rcast<u32*>(image->data) : nullptr;
+	}
+
+	void SoftwareFramebuffer::Upload(
+		const u32* pixels,
+		u32 newWidth,
+		u32 newHeight,
+		u32 stride,
+		SoftwarePixelFormat format)
+	{
+		XImage* image = ToVar<XImage*>(buffers[backBufferIndex].image);
+		if (!image
+			|| !pixels)
+		{
+			return;
+		}
+
+		u32 copyWidth = min(newWidth, width);
+		u32 copyHeight = min(newHeight, height);
+
+		const u8* src = rcast<const u8*>(pixels);
+		u8* dst = rcast<u8*>(image->data);
+
+		for (u32 y = 0; y < copyHeight; ++y)
+		{
+			const u32* srcRow = rcast<const u32*>(src + scast<size_t>(y) * stride);
+			u32* dstRow = rcast<u32*>(dst + scast<size_t>(y) * image->bytes_per_line);
+
+			if (format == SoftwarePixelFormat::PIXEL_BGRA8)
+			{
+				memcpy(dstRow, srcRow, scast<size_t>(copyWidth) * 4);
+			}
+			else SwizzleRow(srcRow, dstRow, copyWidth);
+		}
+	}
+
+	bool SoftwareFramebuffer::Resize(
+		u32 newWidth,
+		u32 newHeight)
+	{
+		if (newWidth == width
+			&& newHeight == height)
+		{
+			return true;
+		}
+
+		DestroyBuffers();
+
+		//the new buffers start empty, nothing of the old frame can be kept
+		ProcessWindow* w = ProcessWindow::GetRegistry().GetContent(windowID);
+		if (w) w->isFullyDamaged = true;
+
+		return CreateBuffers(newWidth, newHeight);
+	}
+
+	void SoftwareFramebuffer::Present()
+	{
+		SoftwareBuffer& back = buffers[backBufferIndex];
+
+		XImage* image = ToVar<XImage*>(back.image);
+		if (!image) return;
+
+		ProcessWindow* w = ProcessWindow::GetRegistry().GetContent(windowID);
+		if (!w) return;
+
+		const X11GlobalData& globalData = Window_Global::GetGlobalData();
+
+		Display* display = ToVar<Display*>(globalData.display);
+		Window window = ToVar<Window>(w->GetWindowData().window);
+		GC context = ToVar<GC>(gc);
+
+		bool isDamageTracked = w->isDamageTracked;
+
+		//damage is in window coordinates, the framebuffer may be smaller than the window
+		vector<WindowRect> rects{};
+		for (const WindowRect& rect : w->TakeDamage())
+		{
+			u32 right = min<u32>(scast<u32>(rect.x) + rect.width, width);
+			u32 bottom = min<u32>(scast<u32>(rect.y) + rect.height, height);
+
+			if (scast<u32>(rect.x) >= right
+				|| scast<u32>(rect.y) >= bottom)
+			{
+				continue;
+			}
+
+			rects.push_back(
+			{
+				rect.x,
+				rect.y,
+				right - scast<u32>(rect.x),
+				bottom - scast<u32>(rect.y)
+			});
+		}
+
+		//no damage inside the framebuffer means the whole frame is sent
+		bool isFullFrame = rects.empty();
+		if (isFullFrame) rects.push_back({ 0, 0, width, height });
+
+		++presentSerial;
+
+		if (isVblankPaced)
+		{
+			Pixmap pixmap = ToVar<Pixmap>(back.pixmap);
+
+			//a pixmap of its own was last filled two presents ago, so it also misses the previous damage
+			if (!back.isPixmapShared)
+			{
+				vector<WindowRect> uploadRects = rects;
+				if (back.isPixmapStale)
+				{
+					uploadRects = { { 0, 0, width, height } };
+				}
+				else uploadRects.insert(uploadRects.end(), lastPresentRects.begin(), lastPresentRects.end());
+
+				for (const WindowRect& rect : uploadRects)
+				{
+					if (isShared)
+					{
+						XShmPutImage(
+							display,
+							pixmap,
+							context,
+							image,
+							rect.x,
+							rect.y,
+							rect.x,
+							rect.y,
+							rect.width,
+							rect.height,
+							False);
+					}
+					else
+					{
+						XPutImage(
+							display,
+							pixmap,
+							context,
+							image,
+							rect.x,
+							rect.y,
+							rect.x,
+							rect.y,
+							rect.width,
+							rect.height);
+					}
+				}
+
+				back.isPixmapStale = false;
+			}
+
+			//the update region only limits copies, a flipped pixmap is always shown whole
+			XserverRegion update = None;
+			if (!isFullFrame)
+			{
+				vector<XRectangle> xrects{};
+				xrects.reserve(rects.size());
+
+				for (const WindowRect& rect : rects)
+				{
+					xrects.push_back(
+					{
+						scast<short>(rect.x),
+						scast<short>(rect.y),
+						scast<unsigned short>(rect.width),
+						scast<unsigned short>(rect.height)
+					});
+				}
+
+				update = XFixesCreateRegion(
+					display,
+					xrects.data(),
+					scast<int>(xrects.size()));
+			}
+
+			//target msc 0 with divisor 0 shows the frame at the next vblank,
+			//the server reports it with PresentCompleteNotify and frees the pixmap with PresentIdleNotify
+			XPresentPixmap(
+				display,
+				window,
+				pixmap,
+				presentSerial,
+				None,
+				update,
+				0,
+				0,
+				None,
+				None,
+				None,
+				PresentOptionNone,
+				0,
+				0,
+				0,
+				nullptr,
+				0);
+
+			if (update != None) XFixesDestroyRegion(display, update);
+
+			back.isBusy = true;
+			lastPresentRects = rects;
+		}
+		else
+		{
+			for (size_t i = 0; i < rects.size(); ++i)
+			{
+				const WindowRect& rect = rects[i];
+
+				if (isShared)
+				{
+					//only the segment ID is sent, the server reads the pixels from shared memory.
+					//ShmCompletion is only asked for the last rect, once it arrives the whole buffer is free
+					XShmPutImage(
+						display,
+						window,
+						context,
+						image,
+						rect.x,
+						rect.y,
+						rect.x,
+						rect.y,
+						rect.width,
+						rect.height,
+						i + 1 == rects.size() ? True : False);
+				}
+				else
+				{
+					XPutImage(
+						display,
+						window,
+						context,
+						image,
+						rect.x,
+						rect.y,
+						rect.x,
+						rect.y,
+						rect.width,
+						rect.height);
+				}
+			}
+
+			if (isShared) back.isBusy = true;
+		}
+
+		//a frame is only done once the server has it, it is not held until the next Update
+		XFlush(display);
+
+		backBufferIndex ^= 1;
+
+		SoftwareBuffer& next = buffers[backBufferIndex];
+		if (next.isBusy)
+		{
+			//the new back buffer was presented one frame ago, once the server has handled
+			//every earlier request it is done reading it even if ShmCompletion was not read yet
+			XSync(display, False);
+
+			if (!isVblankPaced)
+			{
+				next.isBusy = false;
+			}
+			else if (Window_Global::ConsumeRequestErrors(globalData.presentOpcode))
+			{
+				//a present that failed never sends PresentIdleNotify
+				next.isBusy = false;
+				back.isBusy = false;
+
+				Log::Print(
+					"Failed to present software framebuffer '" + to_string(ID) + "' with the Present extension!",
+					"KW_SOFTWARE",
+					LogType::LOG_ERROR,
+					2);
+			}
+
+			//a pixmap stays in use until the frame after it is on the screen,
+			//so this waits for the vblank of the previous frame at most
+			int presentOpcode = globalData.presentOpcode;
+			u64 waitStart = KalaWindowCore::GetMonotonicTime();
+			while (next.isBusy)
+			{
+				XEvent event{};
+				if (XCheckIfEvent(
+					display,
+					&event,
+					IsPresentIdleEvent,
+					rcast<XPointer>(&presentOpcode)))
+				{
+					if (XGetEventData(display, &event.xcookie))
+					{
+						XPresentIdleNotifyEvent* idle = rcast<XPresentIdleNotifyEvent*>(event.xcookie.data);
+						HandleIdle(FromVar(idle->pixmap));
+
+						XFreeEventData(display, &event.xcookie);
+					}
+
+					continue;
+				}
+
+				u64 waited = KalaWindowCore::GetMonotonicTime() - waitStart;
+				if (waited >= PRESENT_IDLE_TIMEOUT)
+				{
+					//the server never freed the pixmap, XShmPutImage does not depend on it
+					next.isBusy = false;
+					back.isBusy = false;
+					isVblankPaced = false;
+
+					Log::Print(
+						"Software framebuffer '" + to_string(ID) + "' did not get PresentIdleNotify in time, falling back to presenting without Present!",
+						"KW_SOFTWARE",
+						LogType::LOG_WARNING);
+
+					break;
+				}
+
+				//sleep until the server sends something instead of spinning on the queue
+				pollfd fd{};
+				fd.fd = ConnectionNumber(display);
+				fd.events = POLLIN;
+
+				poll(
+					&fd,
+					1,
+					scast<int>((PRESENT_IDLE_TIMEOUT - waited) / 1'000'000) + 1);
+			}
+		}
+
+		//with damage tracking the app only redraws what changed, so the new back buffer
+		//gets what was just presented and is the same frame as the window again
+		if (isDamageTracked)
+		{
+			XImage* nextImage = ToVar<XImage*>(next.image);
+
+			for (const WindowRect& rect : rects)
+			{
+				CopyRect(
+					image,
+					nextImage,
+					rect);
+			}
+		}
+	}
+
+	void SoftwareFramebuffer::Destroy() { registry.RemoveContent(ID); }
+
+	bool SoftwareFramebuffer::CreateBuffers(
+		u32 newWidth,
+		u32 newHeight)
+	{
+		Display* display = ToVar<Display*>(Window_Global::GetGlobalData().display);
+		Visual* visualPtr = ToVar<Visual*>(visual);
+
+		//X images can not be empty, a minimized window still keeps a 1x1 buffer
+		newWidth = newWidth > 0 ? newWidth : 1;
+		newHeight = newHeight > 0 ? newHeight : 1;
+
+		bool canShare =
+			Window_Global::GetGlobalData().hasShm
+			&& !isShmBroken;
+
+		for (SoftwareBuffer& buffer : buffers)
+		{
+			if (!canShare) break;
+
+			//the image keeps a pointer to this in obdata, so it lives as long as the image
+			XShmSegmentInfo* info = new XShmSegmentInfo{};
+			info->shmid = -1;
+
+			XImage* image = XShmCreateImage(
+				display,
+				visualPtr,
+				scast<unsigned int>(depth),
+				ZPixmap,
+				nullptr,
+				info,
+				newWidth,
+				newHeight);
+
+			if (image)
+			{
+				info->shmid = shmget(
+					IPC_PRIVATE,
+					scast<size_t>(image->bytes_per_line) * image->height,
+					IPC_CREAT | 0600);
+			}
+			if (info->shmid >= 0)
+			{
+				info->shmaddr = rcast<char*>(shmat(info->shmid, nullptr, 0));
+				info->readOnly = False;
+			}
+
+			if (!image
+				|| info->shmid < 0
+				|| info->shmaddr == rcast<char*>(-1))
+			{
+				if (info->shmid >= 0) shmctl(info->shmid, IPC_RMID, nullptr);
+				if (image)
+				{
+					image->obdata = nullptr;
+					XDestroyImage(image);
+				}
+				delete info;
+
+				Log::Print(
+					"Failed to create MIT-SHM buffer for software framebuffer '" + to_string(ID)
+					+ "', falling back to XPutImage!",
+					"KW_SOFTWARE",
+					LogType::LOG_WARNING);
+
+				DestroyBuffers();
+				canShare = false;
+				isShmBroken = true;
+
+				break;
+			}
+
+			image->data = info->shmaddr;
+
+			//the attach has to reach the server before the segment is marked for removal,
+			//and a remote server only fails it asynchronously
+			XShmAttach(display, info);
+			XSync(display, False);
+
+			shmctl(info->shmid, IPC_RMID, nullptr);
+
+			if (Window_Global::ConsumeRequestErrors(Window_Global::GetGlobalData().shmOpcode))
+			{
+				//never attached, so this one is torn down without a detach
+				shmdt(info->shmaddr);
+				image->data = nullptr;
+				image->obdata = nullptr;
+				XDestroyImage(image);
+				delete info;
+
+				Log::Print(
+					"The X server could not attach MIT-SHM memory for software framebuffer '" + to_string(ID)
+					+ "', falling back to XPutImage!",
+					"KW_SOFTWARE",
+					LogType::LOG_WARNING);
+
+				DestroyBuffers();
+				canShare = false;
+				isShmBroken = true;
+
+				break;
+			}
+
+			buffer.image = FromVar(image);
+			buffer.shmInfo = FromVar(info);
+			buffer.isBusy = false;
+		}
+
+		if (!canShare)
+		{
+			for (SoftwareBuffer& buffer : buffers)
+			{
+				//XDestroyImage frees the pixels with free
+				char* data = scast<char*>(malloc(scast<size_t>(newWidth) * newHeight * 4));
+				if (!data)
+				{
+					DestroyBuffers();
+
+					Log::Print(
+						"Failed to allocate pixels for software framebuffer '" + to_string(ID) + "'!",
+						"KW_SOFTWARE",
+						LogType::LOG_ERROR,
+						2);
+
+					return false;
+				}
+
+				XImage* image = XCreateImage(
+					display,
+					visualPtr,
+					scast<unsigned int>(depth),
+					ZPixmap,
+					0,
+					data,
+					newWidth,
+					newHeight,
+					32,
+					0);
+
+				if (!image)
+				{
+					free(data);
+					DestroyBuffers();
+
+					Log::Print(
+						"Failed to create XImage for software framebuffer '" + to_string(ID) + "'!",
+						"KW_SOFTWARE",
+						LogType::LOG_ERROR,
+						2);
+
+					return false;
+				}
+
+				buffer.image = FromVar(image);
+				buffer.shmInfo = 0;
+				buffer.isBusy = false;
+			}
+		}
+
+		isShared = canShare;
+		width = newWidth;
+		height = newHeight;
+		backBufferIndex = 0;
+
+		//PresentIdleNotify only arrives for windows that selected Present events,
+		//without them every present would wait for an event that never comes
+		ProcessWindow* w = ProcessWindow::GetRegistry().GetContent(windowID);
+		isVblankPaced = w
+			&& w->IsPresentTimingAvailable();
+		lastPresentRects.clear();
+
+		if (isVblankPaced)
+		{
+			Window window = ToVar<Window>(w->GetWindowData().window);
+
+			for (SoftwareBuffer& buffer : buffers)
+			{
+				XShmSegmentInfo* info = ToVar<XShmSegmentInfo*>(buffer.shmInfo);
+
+				//a shared pixmap is the image itself, otherwise damage is copied into the pixmap before presenting
+				Pixmap pixmap{};
+				if (info
+					&& Window_Global::GetGlobalData().hasShmPixmaps)
+				{
+					pixmap = XShmCreatePixmap(
+						display,
+						window,
+						info->shmaddr,
+						info,
+						newWidth,
+						newHeight,
+						scast<unsigned int>(depth));
+
+					buffer.isPixmapShared = true;
+				}
+				else
+				{
+					pixmap = XCreatePixmap(
+						display,
+						window,
+						newWidth,
+						newHeight,
+						scast<unsigned int>(depth));
+
+					buffer.isPixmapStale = true;
+				}
+
+				buffer.pixmap = FromVar(pixmap);
+			}
+		}
+
+		if (isVerboseLoggingEnabled)
+		{
+			Log::Print(
+				"Created '" + to_string(width) + "x" + to_string(height) + "' buffers for software framebuffer '"
+				+ to_string(ID) + "'.",
+				"KW_SOFTWARE",
+				LogType::LOG_VERBOSE);
+		}
+
+		return true;
+	}
+
+	void SoftwareFramebuffer::DestroyBuffers()
+	{
+		Display* display = ToVar<Display*>(Window_Global::GetGlobalData().display);
+
+		//the server keeps presented pixmaps until they are idle, so they can be freed right away
+		for (const SoftwareBuffer& buffer : buffers)
+		{
+			if (buffer.pixmap) XFreePixmap(display, ToVar<Pixmap>(buffer.pixmap));
+		}
+
+		//the server may still be reading a shared buffer, and segments are detached before they go
+		bool isAnyShared{};
+		for (const SoftwareBuffer& buffer : buffers)
+		{
+			if (!buffer.shmInfo) continue;
+
+			XShmDetach(display, ToVar<XShmSegmentInfo*>(buffer.shmInfo));
+			isAnyShared = true;
+		}
+
+		if (isAnyShared) XSync(display, False);
+
+		for (SoftwareBuffer& buffer : buffers)
+		{
+			XImage* image = ToVar<XImage*>(buffer.image);
+			XShmSegmentInfo* info = ToVar<XShmSegmentInfo*>(buffer.shmInfo);
+
+			if (image)
+			{
+				//shared pixels and the segment info are not owned by the image
+				if (info)
+				{
+					image->data = nullptr;
+					image->obdata = nullptr;
+				}
+
+				XDestroyImage(image);
+			}
+
+			if (info)
+			{
+				shmdt(info->shmaddr);
+				delete info;
+			}
+
+			buffer = {};
+		}
+
+		width = 0;
+		height = 0;
+	}
+
+	void SoftwareFramebuffer::HandleCompletion(uintptr_t shmSegment)
+	{
+		for (SoftwareFramebuffer* fb : registry.GetAllContent())
+		{
+			if (!fb) continue;
+
+			for (SoftwareBuffer& buffer : fb->buffers)
+			{
+				XShmSegmentInfo* info = ToVar<XShmSegmentInfo*>(buffer.shmInfo);
+				if (info
+					&& FromVar(info->shmseg) == shmSegment)
+				{
+					buffer.isBusy = false;
+				}
+			}
+		}
+	}
+
+	void SoftwareFramebuffer::HandleIdle(uintptr_t pixmap)
+	{
+		for (SoftwareFramebuffer* fb : registry.GetAllContent())
+		{
+			if (!fb) continue;
+
+			for (SoftwareBuffer& buffer : fb->buffers)
+			{
+				if (buffer.pixmap != 0
+					&& buffer.pixmap == pixmap)
+				{
+					buffer.isBusy = false;
+				}
+			}
+		}
+	}
+
+	SoftwareFramebuffer::~SoftwareFramebuffer()
+	{
+		Log::Print(
+			"Destroying software framebuffer '" + to_string(ID) + "' for window '" + to_string(windowID) + "'.",
+			"KW_SOFTWARE",
+			LogType::LOG_INFO);
+
+		DestroyBuffers();
+
+		if (gc)
+		{
+			Display* display = ToVar<Display*>(Window_Global::GetGlobalData().display);
+
+			XFreeGC(display, ToVar<GC>(gc));
+			gc = 0;
+		}
+	}
+}
+
+#endif //KLIN_ANY
@@ -0,0 +1,242 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include "graphics/kw_vulkan.hpp"
+
+#include <algorithm>
+
+#include "log_utils.hpp"
+
+#include "core/kw_core.hpp"
+#include "core/kw_input.hpp"
+#include "graphics/kw_window.hpp"
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+
+using KalaWindow::Core::KalaWindowCore;
+using KalaWindow::Core::Input;
+using KalaWindow::Graphics::VulkanContext;
+using KalaWindow::Graphics::ProcessWindow;
+using KalaWindow::Graphics::WindowRect;
+using KalaWindow::Graphics::LatencyFrame;
+using KalaWindow::Graphics::LatencyPercentiles;
+using KalaWindow::Graphics::LatencyStats;
+
+using std::lock_guard;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::nth_element;
+using std::max_element;
+using std::to_string;
+using std::vector;
+
+//Returns b - a, or 0 if either stage was never reached
+static u64 StageDuration(u64 a, u64 b)
+{
+	if (a == 0
+		|| b == 0
+		|| b < a)
+	{
+		return 0;
+	}
+
+	return b - a;
+}
+
+static LatencyPercentiles GetPercentiles(vector<u64>& values)
+{
+	LatencyPercentiles result{};
+
+	if (values.empty()) return result;
+
+	auto percentile = [&values](u32 p) -> u64
+		{
+			size_t index = (values.size() - 1) * p / 100;
+			nth_element(values.begin(), values.begin() + index, values.end());
+			return values[index];
+		};
+
+	result.p50 = percentile(50);
+	result.p90 = percentile(90);
+	result.p99 = percentile(99);
+	result.max = *max_element(values.begin(), values.end());
+
+	return result;
+}
+
+namespace KalaWindow::Graphics
+{
+	u64 VulkanContext::MarkSimulationStart()
+	{
+		u64 simulationTime = KalaWindowCore::GetMonotonicTime();
+
+		//every input of this window feeds the same simulation step,
+		//the oldest pending event is what the user has been waiting on the longest
+		u64 inputTime{};
+		for (Input* input : Input::GetRegistry().GetAllWindowContent(windowID))
+		{
+			u64 eventTime = input->ConsumeEventTime();
+			if (eventTime == 0) continue;
+
+			if (inputTime == 0
+				|| eventTime < inputTime)
+			{
+				inputTime = eventTime;
+			}
+		}
+
+		lock_guard lock(latencyMutex);
+
+		u64 frameID = ++lastFrameID;
+
+		LatencyFrame& frame = inFlightFrames[frameID % MAX_FRAMES_IN_FLIGHT];
+		if (frame.frameID != 0
+			&& frame.presentTime == 0
+			&& IsVerboseLoggingEnabled())
+		{
+			Log::Print(
+				"Dropped latency frame '" + to_string(frame.frameID) + "' for Vulkan context '"
+				+ to_string(ID) + "' because it was never presented!",
+				"KW_VULKAN",
+				LogType::LOG_WARNING);
+		}
+
+		frame = {};
+		frame.frameID = frameID;
+		frame.inputTime = inputTime;
+		frame.simulationTime = simulationTime;
+
+#if defined(KLIN_ANY)
+		//the WM is told about the new frame on the same main thread call
+		ProcessWindow* window = ProcessWindow::GetRegistry().GetContent(windowID);
+		if (window) window->BeginSyncFrame(frameID);
+#endif
+
+		return frameID;
+	}
+
+	void VulkanContext::MarkRenderSubmit(u64 frameID)
+	{
+		u64 submitTime = KalaWindowCore::GetMonotonicTime();
+
+		lock_guard lock(latencyMutex);
+
+		LatencyFrame* frame = GetInFlightFrame(frameID);
+		if (!frame) return;
+
+		frame->submitTime = submitTime;
+	}
+
+	void VulkanContext::MarkPresent(u64 frameID)
+	{
+		u64 presentTime = KalaWindowCore::GetMonotonicTime();
+
+		lock_guard lock(latencyMutex);
+
+		LatencyFrame* frame = GetInFlightFrame(frameID);
+		if (!frame) return;
+
+		frame->presentTime = presentTime;
+
+		frame->inputToSimulation = StageDuration(frame->inputTime, frame->simulationTime);
+		frame->simulationToSubmit = StageDuration(frame->simulationTime, frame->submitTime);
+		frame->submitToPresent = StageDuration(frame->submitTime, frame->presentTime);
+		frame->inputToPresent = StageDuration(frame->inputTime, frame->presentTime);
+
+		latencyHistory[latencyHistoryNext] = *frame;
+		latencyHistoryNext = (latencyHistoryNext + 1) % LATENCY_HISTORY_SIZE;
+		if (latencyHistoryCount < LATENCY_HISTORY_SIZE) ++latencyHistoryCount;
+
+		lastPresentedFrameID.store(frameID, memory_order_release);
+	}
+
+	vector<WindowRect> VulkanContext::GetPresentRegions()
+	{
+		ProcessWindow* window = ProcessWindow::GetRegistry().GetContent(windowID);
+		if (!window) return {};
+
+		return window->TakeDamage();
+	}
+
+	u64 VulkanContext::GetLastPresentedFrameID() const
+	{
+		return lastPresentedFrameID.load(memory_order_acquire);
+	}
+
+	LatencyFrame VulkanContext::GetLastLatencyFrame()
+	{
+		lock_guard lock(latencyMutex);
+
+		if (latencyHistoryCount == 0) return {};
+
+		u32 last = (latencyHistoryNext + LATENCY_HISTORY_SIZE - 1) % LATENCY_HISTORY_SIZE;
+		return latencyHistory[last];
+	}
+
+	LatencyStats VulkanContext::GetLatencyStats()
+	{
+		vector<u64> inputToSimulation{};
+		vector<u64> simulationToSubmit{};
+		vector<u64> submitToPresent{};
+		vector<u64> inputToPresent{};
+
+		{
+			lock_guard lock(latencyMutex);
+
+			inputToSimulation.reserve(latencyHistoryCount);
+			simulationToSubmit.reserve(latencyHistoryCount);
+			submitToPresent.reserve(latencyHistoryCount);
+			inputToPresent.reserve(latencyHistoryCount);
+
+			for (u32 i = 0; i < latencyHistoryCount; ++i)
+			{
+				const LatencyFrame& frame = latencyHistory[i];
+
+				simulationToSubmit.push_back(frame.simulationToSubmit);
+				submitToPresent.push_back(frame.submitToPresent);
+
+				//frames without input would drag the input percentiles towards zero
+				if (frame.inputTime == 0) continue;
+
+				inputToSimulation.push_back(frame.inputToSimulation);
+				inputToPresent.push_back(frame.inputToPresent);
+			}
+		}
+
+		LatencyStats stats{};
+
+		stats.frameCount = scast<u32>(simulationToSubmit.size());
+		stats.inputFrameCount = scast<u32>(inputToPresent.size());
+
+		stats.inputToSimulation = GetPercentiles(inputToSimulation);
+		stats.simulationToSubmit = GetPercentiles(simulationToSubmit);
+		stats.submitToPresent = GetPercentiles(submitToPresent);
+		stats.inputToPresent = GetPercentiles(inputToPresent);
+
+		return stats;
+	}
+
+	LatencyFrame* VulkanContext::GetInFlightFrame(u64 frameID)
+	{
+		//caller holds latencyMutex
+		if (frameID == 0
+			|| frameID > lastFrameID)
+		{
+			return nullptr;
+		}
+
+		LatencyFrame& frame = inFlightFrames[frameID % MAX_FRAMES_IN_FLIGHT];
+
+		//the slot was reused by a newer frame or this frame was already presented
+		if (frame.frameID != frameID
+			|| frame.presentTime != 0)
+		{
+			return nullptr;
+		}
+
+		return &frame;
+	}
+}
@@ -473,11 +473,21 @@ namespace KalaWindow::Graphics
 			return nullptr;
         }
 
-        u32 newID = KalaWindowCore::GetGlobalID() + 1;
-		KalaWindowCore::SetGlobalID(newID);
+        u32 newID = registry.AddContent(windowID);
+		if (newID == 0)
+		{
+			vkDestroySurfaceKHR(instance, surface, nullptr);
+
+			Log::Print(
+				"Failed to initialize Vulkan context for window '" + to_string(windowID) + "' because the Vulkan context registry is full!",
+				"KW_VULKAN",
+				LogType::LOG_ERROR,
+				2);
 
-		unique_ptr<VulkanContext> newCont = make_unique<VulkanContext>();
-		VulkanContext* contPtr = newCont.get();
+			return nullptr;
+		}
+
+		VulkanContext* contPtr = registry.GetContent(newID);
 
 		contPtr->ID = newID;
 
@@ -486,8 +496,6 @@ namespace KalaWindow::Graphics
 		contPtr->windowID = w->GetID();
         contPtr->surface = surface;
 
-        registry.AddContent(newID, std::move(newCont));
-
 		Log::Print(
 			"Created new Vulkan context '" + to_string(newID) + "' for window '" + to_string(w->GetID()) + "'!",
 			"KW_VULKAN",
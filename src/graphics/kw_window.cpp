@@ -0,0 +1,120 @@
+//Copyright(C) 2026 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include "graphics/kw_window.hpp"
+
+#include <algorithm>
+
+using KalaWindow::Graphics::ProcessWindow;
+using KalaWindow::Graphics::WindowRect;
+
+using std::min;
+using std::max;
+using std::vector;
+
+//Returns true if inner is fully covered by outer
+static bool ContainsRect(
+	const WindowRect& outer,
+	const WindowRect& inner)
+{
+	return inner.x >= outer.x
+		&& inner.y >= outer.y
+		&& inner.x + scast<i64>(inner.width) <= outer.x + scast<i64>(outer.width)
+		&& inner.y + scast<i64>(inner.height) <= outer.y + scast<i64>(outer.height);
+}
+
+namespace KalaWindow::Graphics
+{
+	void ProcessWindow::AddDamage(const WindowRect& rect)
+	{
+		isDamageTracked = true;
+		AppendDamage(rect);
+	}
+	void ProcessWindow::AddFullDamage()
+	{
+		isDamageTracked = true;
+		isFullyDamaged = true;
+		damageRects.clear();
+	}
+
+	const vector<WindowRect>& ProcessWindow::GetDamage() const { return damageRects; }
+	bool ProcessWindow::IsFullyDamaged() const { return isFullyDamaged || !isDamageTracked; }
+
+	void ProcessWindow::AppendDamage(const WindowRect& rect)
+	{
+		if (isFullyDamaged) return;
+
+		vec2 windowSize = GetSize();
+
+		//clip to the window, damage outside of it can never be presented
+		i64 left = max<i64>(rect.x, 0);
+		i64 top = max<i64>(rect.y, 0);
+		i64 right = min<i64>(rect.x + scast<i64>(rect.width), scast<i64>(windowSize.x));
+		i64 bottom = min<i64>(rect.y + scast<i64>(rect.height), scast<i64>(windowSize.y));
+
+		if (right <= left
+			|| bottom <= top)
+		{
+			return;
+		}
+
+		WindowRect clipped =
+		{
+			scast<i32>(left),
+			scast<i32>(top),
+			scast<u32>(right - left),
+			scast<u32>(bottom - top)
+		};
+
+		for (const auto& existing : damageRects)
+		{
+			if (ContainsRect(existing, clipped)) return;
+		}
+
+		if (damageRects.size() < MAX_DAMAGE_RECTS)
+		{
+			damageRects.push_back(clipped);
+			return;
+		}
+
+		//too many small rects cost more per present than one larger one,
+		//merge everything into the bounding box instead
+		for (const auto& existing : damageRects)
+		{
+			left = min<i64>(left, existing.x);
+			top = min<i64>(top, existing.y);
+			right = max<i64>(right, existing.x + scast<i64>(existing.width));
+			bottom = max<i64>(bottom, existing.y + scast<i64>(existing.height));
+		}
+
+		damageRects.clear();
+		damageRects.push_back(
+		{
+			scast<i32>(left),
+			scast<i32>(top),
+			scast<u32>(right - left),
+			scast<u32>(bottom - top)
+		});
+	}
+
+	vector<WindowRect> ProcessWindow::TakeDamage()
+	{
+		vector<WindowRect> result{};
+
+		//nothing new to present is still presented as a full frame,
+		//the caller asked for a present so something must have changed
+		if (isDamageTracked
+			&& !isFullyDamaged
+			&& !damageRects.empty())
+		{
+			result.swap(damageRects);
+		}
+
+		damageRects.clear();
+		isFullyDamaged = false;
+
+		return result;
+	}
+}
@@ -10,6 +10,11 @@
 #include <X11/Xlib.h>
 #include <X11/extensions/XI2.h>
 #include <X11/extensions/XInput2.h>
+#include <X11/extensions/Xrandr.h>
+#include <X11/extensions/sync.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xfixes.h>
+#include <X11/extensions/Xpresent.h>
 #include <X11/Xatom.h>
 #include <sys/wait.h>
 #include <glib.h>
@@ -19,6 +24,8 @@
 
 #include <string>
 #include <array>
+#include <cmath>
+#include <algorithm>
 
 #include "core_utils.hpp"
 #include "log_utils.hpp"
@@ -37,6 +44,8 @@ using KalaHeaders::KalaLog::LogType;
 using KalaHeaders::KalaString::SplitString;
 
 using KalaWindow::Graphics::Window_Global;
+using KalaWindow::Graphics::X11Error;
+using KalaWindow::Graphics::MonitorData;
 using KalaWindow::Core::KalaWindowCore;
 using KalaWindow::Core::Input;
 using KalaWindow::Core::MAX_NAME_LENGTH;
@@ -45,6 +54,9 @@ using KalaWindow::Core::CrashHandler;
 using std::string;
 using std::to_string;
 using std::array;
+using std::fabs;
+using std::remove_if;
+using std::vector;
 using std::error_code;
 
 static bool foundCanberra = true;
@@ -66,6 +78,10 @@ static bool CommandSucceeds(const string& cmd)
         && WEXITSTATUS(status) == 0;
 }
 
+//Errors received since ProcessWindow::Update last dispatched them,
+//Xlib only calls the error handler from the thread that uses the display
+static vector<X11Error> pendingErrors{};
+
 static int ErrorHandler(
     Display* display,
     XErrorEvent* error)
@@ -102,9 +118,82 @@ static int ErrorHandler(
         LogType::LOG_ERROR,
         2);
 
+    X11Error newError{};
+    newError.resourceID = scast<uintptr_t>(error->resourceid);
+    newError.serial = scast<u64>(error->serial);
+    newError.errorCode = error->error_code;
+    newError.requestCode = error->request_code;
+    newError.minorCode = error->minor_code;
+    newError.message = buffer;
+
+    pendingErrors.push_back(std::move(newError));
+
     return 0; //tells X to continue
 }
 
+//Refresh rate of a mode in Hz, 0 if the mode is unknown
+static f32 GetRefreshRate(
+    const XRRScreenResources* resources,
+    RRMode mode)
+{
+    for (int i = 0; i < resources->nmode; ++i)
+    {
+        const XRRModeInfo& info = resources->modes[i];
+        if (info.id != mode) continue;
+
+        f64 vTotal = info.vTotal;
+        if (info.modeFlags & RR_DoubleScan) vTotal *= 2.0;
+        if (info.modeFlags & RR_Interlace) vTotal /= 2.0;
+
+        if (info.hTotal == 0
+            || vTotal == 0.0)
+        {
+            return 0.0f;
+        }
+
+        return scast<f32>(scast<f64>(info.dotClock) / (info.hTotal * vTotal));
+    }
+
+    return 0.0f;
+}
+
+//How many CRTCs can have their mode changed at the same time
+static constexpr size_t MAX_SAVED_CRTCS = 8;
+static constexpr size_t MAX_CRTC_OUTPUTS = 8;
+
+//Original CRTC configuration, fixed size so the crash handler can read it without allocating
+struct SavedCrtc
+{
+    RRCrtc crtc{};
+    RRMode mode{};
+    int x{};
+    int y{};
+    Rotation rotation{};
+    array<RROutput, MAX_CRTC_OUTPUTS> outputs{};
+    int outputCount{};
+};
+
+static array<SavedCrtc, MAX_SAVED_CRTCS> savedCrtcs{};
+static size_t savedCrtcCount{};
+
+static Status ApplySavedCrtc(
+    Display* display,
+    XRRScreenResources* resources,
+    const SavedCrtc& saved)
+{
+    return XRRSetCrtcConfig(
+        display,
+        resources,
+        saved.crtc,
+        CurrentTime,
+        saved.x,
+        saved.y,
+        saved.mode,
+        saved.rotation,
+        const_cast<RROutput*>(saved.outputs.data()),
+        saved.outputCount);
+}
+
 static int IOErrorHandler(Display* display)
 {
     KalaWindowCore::ForceClose(
@@ -121,6 +210,9 @@ namespace KalaWindow::Graphics
 
     static X11GlobalData globalData{};
 
+    static vector<MonitorData> monitors{};
+    static function<void()> monitorsChangedCallback{};
+
 	bool Window_Global::IsVerboseLoggingEnabled() { return isVerboseLoggingEnabled; }
     void Window_Global::SetVerboseLoggingState(bool newState) { isVerboseLoggingEnabled = newState; }
 
@@ -239,6 +331,124 @@ namespace KalaWindow::Graphics
             &mask, 
             1);
 
+        int randrEventBase{};
+        int randrErrorBase{};
+
+        //monitor changes are sent to the root window, without XRandR there is only the root window
+        bool hasRandr = XRRQueryExtension(
+            display,
+            &randrEventBase,
+            &randrErrorBase);
+
+        if (hasRandr)
+        {
+            XRRSelectInput(
+                display,
+                root,
+                RRScreenChangeNotifyMask
+                | RRCrtcChangeNotifyMask
+                | RROutputChangeNotifyMask);
+        }
+        else
+        {
+            Log::Print(
+                "XRandR is not available! The root window is reported as the only monitor.",
+                "KW_WINDOW_GLOBAL",
+                LogType::LOG_WARNING);
+        }
+
+        int syncEventBase{};
+        int syncErrorBase{};
+        int syncMajor{};
+        int syncMinor{};
+
+        //without XSync the WM does not wait for frames during resize, windows still work
+        bool hasSync =
+            XSyncQueryExtension(
+                display,
+                &syncEventBase,
+                &syncErrorBase)
+            && XSyncInitialize(
+                display,
+                &syncMajor,
+                &syncMinor);
+
+        if (!hasSync)
+        {
+            Log::Print(
+                "XSync is not available! Windows will not take part in _NET_WM_SYNC_REQUEST.",
+                "KW_WINDOW_GLOBAL",
+                LogType::LOG_WARNING);
+        }
+
+        int shmOpcode{};
+        int shmEventBase{};
+        int shmErrorBase{};
+
+        //software framebuffers use XPutImage without MIT-SHM
+        bool hasShm =
+            XQueryExtension(
+                display,
+                "MIT-SHM",
+                &shmOpcode,
+                &shmEventBase,
+                &shmErrorBase)
+            && XShmQueryExtension(display);
+
+        int shmMajor{};
+        int shmMinor{};
+        Bool shmPixmaps{};
+
+        //shared pixmaps let the Present extension read software framebuffers without a copy
+        bool hasShmPixmaps =
+            hasShm
+            && XShmQueryVersion(
+                display,
+                &shmMajor,
+                &shmMinor,
+                &shmPixmaps)
+            && shmPixmaps
+            && XShmPixmapFormat(display) == ZPixmap;
+
+        int presentOpcode{};
+        int presentEventBase{};
+        int presentErrorBase{};
+        int presentMajor{};
+        int presentMinor{};
+
+        int fixesEventBase{};
+        int fixesErrorBase{};
+        int fixesMajor = 2;
+        int fixesMinor = 0;
+
+        //without Present there are no vblank timings and software framebuffers are not paced
+        bool hasPresent =
+            XPresentQueryExtension(
+                display,
+                &presentOpcode,
+                &presentEventBase,
+                &presentErrorBase)
+            && XPresentQueryVersion(
+                display,
+                &presentMajor,
+                &presentMinor)
+            && XFixesQueryExtension(
+                display,
+                &fixesEventBase,
+                &fixesErrorBase)
+            && XFixesQueryVersion(
+                display,
+                &fixesMajor,
+                &fixesMinor);
+
+        if (!hasPresent)
+        {
+            Log::Print(
+                "Present is not available! Windows will not report present timings.",
+                "KW_WINDOW_GLOBAL",
+                LogType::LOG_WARNING);
+        }
+
         //flush now and detect errors via ErrorHandler
         XSync(display, False);
 
@@ -316,6 +526,52 @@ namespace KalaWindow::Graphics
             display,
             "_NET_WM_WINDOW_TYPE_NORMAL",
             False);
+        Atom net_wm_window_type_tooltip = XInternAtom(
+            display,
+            "_NET_WM_WINDOW_TYPE_TOOLTIP",
+            False);
+        Atom net_wm_window_type_dropdown_menu = XInternAtom(
+            display,
+            "_NET_WM_WINDOW_TYPE_DROPDOWN_MENU",
+            False);
+        Atom net_wm_window_type_popup_menu = XInternAtom(
+            display,
+            "_NET_WM_WINDOW_TYPE_POPUP_MENU",
+            False);
+        Atom net_wm_window_type_combo = XInternAtom(
+            display,
+            "_NET_WM_WINDOW_TYPE_COMBO",
+            False);
+
+        Atom net_wm_bypass_compositor = XInternAtom(
+            display,
+            "_NET_WM_BYPASS_COMPOSITOR",
+            False);
+        Atom net_wm_opaque_region = XInternAtom(
+            display,
+            "_NET_WM_OPAQUE_REGION",
+            False);
+        Atom variable_refresh = XInternAtom(
+            display,
+            "_VARIABLE_REFRESH",
+            False);
+
+        Atom net_wm_sync_request = XInternAtom(
+            display,
+            "_NET_WM_SYNC_REQUEST",
+            False);
+        Atom net_wm_sync_request_counter = XInternAtom(
+            display,
+            "_NET_WM_SYNC_REQUEST_COUNTER",
+            False);
+        Atom net_wm_frame_drawn = XInternAtom(
+            display,
+            "_NET_WM_FRAME_DRAWN",
+            False);
+        Atom net_wm_frame_timings = XInternAtom(
+            display,
+            "_NET_WM_FRAME_TIMINGS",
+            False);
 
         Atom net_wm_allowed_actions = XInternAtom(
             display,
@@ -355,6 +611,10 @@ namespace KalaWindow::Graphics
            "_NET_WM_STATE_SKIP_TASKBAR",
             False);
 
+        Atom wm_protocols = XInternAtom(
+            display,
+            "WM_PROTOCOLS",
+            False);
         Atom wm_delete = XInternAtom(
             display,
             "WM_DELETE_WINDOW",
@@ -368,6 +628,22 @@ namespace KalaWindow::Graphics
         globalData.xiErrorBase = error;
         globalData.xiOpcode = opCode;
 
+        globalData.hasRandr = hasRandr;
+        globalData.randrEventBase = randrEventBase;
+        globalData.randrErrorBase = randrErrorBase;
+
+        globalData.hasSync = hasSync;
+        globalData.syncEventBase = syncEventBase;
+        globalData.syncErrorBase = syncErrorBase;
+
+        globalData.hasShm = hasShm;
+        globalData.hasShmPixmaps = hasShmPixmaps;
+        globalData.shmOpcode = shmOpcode;
+        globalData.shmEventBase = shmEventBase;
+
+        globalData.hasPresent = hasPresent;
+        globalData.presentOpcode = presentOpcode;
+
         globalData.atom_utf8 = FromVar(utf8);
 
         globalData.atom_xDndAware      = FromVar(xdndAware);
@@ -390,6 +666,19 @@ namespace KalaWindow::Graphics
 
         globalData.atom_net_wm_window_type        = FromVar(net_wm_window_type);
         globalData.atom_net_wm_window_type_normal = FromVar(net_wm_window_type_normal);
+        globalData.atom_net_wm_window_type_tooltip       = FromVar(net_wm_window_type_tooltip);
+        globalData.atom_net_wm_window_type_dropdown_menu = FromVar(net_wm_window_type_dropdown_menu);
+        globalData.atom_net_wm_window_type_popup_menu    = FromVar(net_wm_window_type_popup_menu);
+        globalData.atom_net_wm_window_type_combo         = FromVar(net_wm_window_type_combo);
+
+        globalData.atom_net_wm_bypass_compositor = FromVar(net_wm_bypass_compositor);
+        globalData.atom_net_wm_opaque_region     = FromVar(net_wm_opaque_region);
+        globalData.atom_variable_refresh         = FromVar(variable_refresh);
+
+        globalData.atom_net_wm_sync_request         = FromVar(net_wm_sync_request);
+        globalData.atom_net_wm_sync_request_counter = FromVar(net_wm_sync_request_counter);
+        globalData.atom_net_wm_frame_drawn          = FromVar(net_wm_frame_drawn);
+        globalData.atom_net_wm_frame_timings        = FromVar(net_wm_frame_timings);
 
         globalData.atom_net_wm_allowed_actions = FromVar(net_wm_allowed_actions);
         globalData.atom_net_wm_action_resize   = FromVar(net_wm_action_resize);
@@ -402,8 +691,11 @@ namespace KalaWindow::Graphics
         globalData.atom_net_wm_state_above        = FromVar(net_wm_state_above);
         globalData.atom_net_wm_state_skip_taskbar = FromVar(net_wm_state_skip_taskbar);
 
+        globalData.atom_wm_protocols = FromVar(wm_protocols);
         globalData.atom_wm_delete = FromVar(wm_delete);
 
+        UpdateMonitors();
+
         //initialize libnotify
         notify_init("KalaWindow");
 
@@ -428,6 +720,376 @@ namespace KalaWindow::Graphics
 
     const X11GlobalData& Window_Global::GetGlobalData() { return globalData; }
 
+    const vector<MonitorData>& Window_Global::GetMonitors() { return monitors; }
+
+    const MonitorData* Window_Global::GetPrimaryMonitor()
+    {
+        for (const MonitorData& monitor : monitors)
+        {
+            if (monitor.isPrimary) return &monitor;
+        }
+
+        return monitors.empty() ? nullptr : &monitors.front();
+    }
+
+    void Window_Global::SetMonitorsChangedCallback(function<void()>&& newValue)
+    {
+        monitorsChangedCallback = std::move(newValue);
+    }
+
+    void Window_Global::UpdateMonitors()
+    {
+        Display* display = ToVar<Display*>(globalData.display);
+        Window root = ToVar<Window>(globalData.window_root);
+
+        monitors.clear();
+
+        XRRScreenResources* resources = globalData.hasRandr
+            ? XRRGetScreenResourcesCurrent(display, root)
+            : nullptr;
+
+        if (resources)
+        {
+            RROutput primary = XRRGetOutputPrimary(display, root);
+
+            for (int i = 0; i < resources->noutput; ++i)
+            {
+                XRROutputInfo* outputInfo = XRRGetOutputInfo(
+                    display,
+                    resources,
+                    resources->outputs[i]);
+
+                if (!outputInfo) continue;
+
+                //disconnected or disabled outputs have no geometry
+                if (outputInfo->connection != RR_Connected
+                    || outputInfo->crtc == None)
+                {
+                    XRRFreeOutputInfo(outputInfo);
+                    continue;
+                }
+
+                XRRCrtcInfo* crtcInfo = XRRGetCrtcInfo(
+                    display,
+                    resources,
+                    outputInfo->crtc);
+
+                if (crtcInfo)
+                {
+                    MonitorData monitor{};
+                    monitor.output = FromVar(resources->outputs[i]);
+                    monitor.crtc = FromVar(outputInfo->crtc);
+                    monitor.name.assign(outputInfo->name, outputInfo->nameLen);
+
+                    monitor.x = crtcInfo->x;
+                    monitor.y = crtcInfo->y;
+                    monitor.width = crtcInfo->width;
+                    monitor.height = crtcInfo->height;
+
+                    monitor.refreshRate = GetRefreshRate(resources, crtcInfo->mode);
+                    monitor.isPrimary = resources->outputs[i] == primary;
+
+                    monitors.push_back(std::move(monitor));
+
+                    XRRFreeCrtcInfo(crtcInfo);
+                }
+
+                XRRFreeOutputInfo(outputInfo);
+            }
+
+            XRRFreeScreenResources(resources);
+        }
+
+        if (monitors.empty())
+        {
+            int screen = DefaultScreen(display);
+
+            MonitorData monitor{};
+            monitor.name = "root";
+            monitor.width = scast<u32>(DisplayWidth(display, screen));
+            monitor.height = scast<u32>(DisplayHeight(display, screen));
+            monitor.isPrimary = true;
+
+            monitors.push_back(std::move(monitor));
+        }
+
+        if (isVerboseLoggingEnabled)
+        {
+            Log::Print(
+                "Found '" + to_string(monitors.size()) + "' monitors.",
+                "KW_WINDOW_GLOBAL",
+                LogType::LOG_VERBOSE);
+        }
+
+        //the startup query is not a change
+        if (isInitialized
+            && monitorsChangedCallback)
+        {
+            monitorsChangedCallback();
+        }
+    }
+
+    bool Window_Global::SetCrtcMode(
+        uintptr_t crtc,
+        u32 width,
+        u32 height,
+        f32 refreshRate)
+    {
+        if (!globalData.hasRandr
+            || crtc == 0)
+        {
+            Log::Print(
+                "Failed to set display mode because XRandR is not available!",
+                "KW_WINDOW_GLOBAL",
+                LogType::LOG_ERROR,
+                2);
+
+            return false;
+        }
+
+        Display* display = ToVar<Display*>(globalData.display);
+        Window root = ToVar<Window>(globalData.window_root);
+        RRCrtc targetCrtc = ToVar<RRCrtc>(crtc);
+
+        XRRScreenResources* resources = XRRGetScreenResourcesCurrent(display, root);
+        if (!resources)
+        {
+            Log::Print(
+                "Failed to set display mode because screen resources could not be queried!",
+                "KW_WINDOW_GLOBAL",
+                LogType::LOG_ERROR,
+                2);
+
+            return false;
+        }
+
+        XRRCrtcInfo* crtcInfo = XRRGetCrtcInfo(display, resources, targetCrtc);
+        if (!crtcInfo
+            || crtcInfo->noutput == 0)
+        {
+            if (crtcInfo) XRRFreeCrtcInfo(crtcInfo);
+            XRRFreeScreenResources(resources);
+
+            Log::Print(
+                "Failed to set display mode because CRTC '" + to_string(crtc) + "' drives no outputs!",
+                "KW_WINDOW_GLOBAL",
+                LogType::LOG_ERROR,
+                2);
+
+            return false;
+        }
+
+        if (refreshRate <= 0.0f) refreshRate = GetRefreshRate(resources, crtcInfo->mode);
+
+        //only modes every output of this CRTC supports are valid, the first output is enough in practice
+        XRROutputInfo* outputInfo = XRRGetOutputInfo(display, resources, crtcInfo->outputs[0]);
+
+        RRMode bestMode = None;
+        f32 bestDifference{};
+
+        for (int i = 0; outputInfo && i < outputInfo->nmode; ++i)
+        {
+            for (int j = 0; j < resources->nmode; ++j)
+            {
+                const XRRModeInfo& info = resources->modes[j];
+                if (info.id != outputInfo->modes[i]
+                    || info.width != width
+                    || info.height != height)
+                {
+                    continue;
+                }
+
+                f32 difference = fabs(GetRefreshRate(resources, info.id) - refreshRate);
+                if (bestMode == None
+                    || difference < bestDifference)
+                {
+                    bestMode = info.id;
+                    bestDifference = difference;
+                }
+            }
+        }
+
+        if (outputInfo) XRRFreeOutputInfo(outputInfo);
+
+        if (bestMode == None)
+        {
+            XRRFreeCrtcInfo(crtcInfo);
+            XRRFreeScreenResources(resources);
+
+            Log::Print(
+                "Failed to set display mode because CRTC '" + to_string(crtc) + "' has no '"
+                + to_string(width) + "x" + to_string(height) + "' mode!",
+                "KW_WINDOW_GLOBAL",
+                LogType::LOG_ERROR,
+                2);
+
+            return false;
+        }
+
+        bool isSaved{};
+        for (size_t i = 0; i < savedCrtcCount; ++i)
+        {
+            if (savedCrtcs[i].crtc == targetCrtc) isSaved = true;
+        }
+
+        if (!isSaved)
+        {
+            if (savedCrtcCount == MAX_SAVED_CRTCS
+                || crtcInfo->noutput > scast<int>(MAX_CRTC_OUTPUTS))
+            {
+                XRRFreeCrtcInfo(crtcInfo);
+                XRRFreeScreenResources(resources);
+
+                Log::Print(
+                    "Failed to set display mode because the original mode of CRTC '"
+                    + to_string(crtc) + "' can not be saved!",
+                    "KW_WINDOW_GLOBAL",
+                    LogType::LOG_ERROR,
+                    2);
+
+                return false;
+            }
+
+            SavedCrtc& saved = savedCrtcs[savedCrtcCount];
+            saved.crtc = targetCrtc;
+            saved.mode = crtcInfo->mode;
+            saved.x = crtcInfo->x;
+            saved.y = crtcInfo->y;
+            saved.rotation = crtcInfo->rotation;
+            saved.outputCount = crtcInfo->noutput;
+            for (int i = 0; i < crtcInfo->noutput; ++i)
+            {
+                saved.outputs[i] = crtcInfo->outputs[i];
+            }
+
+            ++savedCrtcCount;
+        }
+
+        //the root window keeps its size, a smaller mode just shows less of it
+        Status status = XRRSetCrtcConfig(
+            display,
+            resources,
+            targetCrtc,
+            CurrentTime,
+            crtcInfo->x,
+            crtcInfo->y,
+            bestMode,
+            crtcInfo->rotation,
+            crtcInfo->outputs,
+            crtcInfo->noutput);
+
+        XRRFreeCrtcInfo(crtcInfo);
+        XRRFreeScreenResources(resources);
+
+        if (status != RRSetConfigSuccess)
+        {
+            Log::Print(
+                "Failed to set CRTC '" + to_string(crtc) + "' to '"
+                + to_string(width) + "x" + to_string(height) + "'! Reason: " + to_string(status),
+                "KW_WINDOW_GLOBAL",
+                LogType::LOG_ERROR,
+                2);
+
+            return false;
+        }
+
+        if (isVerboseLoggingEnabled)
+        {
+            Log::Print(
+                "Set CRTC '" + to_string(crtc) + "' to '"
+                + to_string(width) + "x" + to_string(height) + "'.",
+                "KW_WINDOW_GLOBAL",
+                LogType::LOG_VERBOSE);
+        }
+
+        return true;
+    }
+
+    void Window_Global::RestoreCrtcMode(uintptr_t crtc)
+    {
+        RRCrtc targetCrtc = ToVar<RRCrtc>(crtc);
+
+        for (size_t i = 0; i < savedCrtcCount; ++i)
+        {
+            if (savedCrtcs[i].crtc != targetCrtc) continue;
+
+            Display* display = ToVar<Display*>(globalData.display);
+            Window root = ToVar<Window>(globalData.window_root);
+
+            XRRScreenResources* resources = XRRGetScreenResourcesCurrent(display, root);
+            if (resources)
+            {
+                if (ApplySavedCrtc(display, resources, savedCrtcs[i]) != RRSetConfigSuccess)
+                {
+                    Log::Print(
+                        "Failed to restore the original mode of CRTC '" + to_string(crtc) + "'!",
+                        "KW_WINDOW_GLOBAL",
+                        LogType::LOG_ERROR,
+                        2);
+                }
+
+                XRRFreeScreenResources(resources);
+            }
+
+            //swap with last, the order does not matter
+            savedCrtcs[i] = savedCrtcs[savedCrtcCount - 1];
+            --savedCrtcCount;
+
+            return;
+        }
+    }
+
+    void Window_Global::RestoreAllCrtcModes(bool useNewConnection)
+    {
+        if (savedCrtcCount == 0) return;
+
+        Display* display = useNewConnection
+            ? XOpenDisplay(nullptr)
+            : ToVar<Display*>(globalData.display);
+
+        if (!display) return;
+
+        XRRScreenResources* resources = XRRGetScreenResourcesCurrent(
+            display,
+            DefaultRootWindow(display));
+
+        if (resources)
+        {
+            for (size_t i = 0; i < savedCrtcCount; ++i)
+            {
+                ApplySavedCrtc(display, resources, savedCrtcs[i]);
+            }
+
+            XRRFreeScreenResources(resources);
+        }
+
+        savedCrtcCount = 0;
+
+        if (useNewConnection) XCloseDisplay(display);
+        else XFlush(display);
+    }
+
+    vector<X11Error> Window_Global::ConsumeErrors()
+    {
+        vector<X11Error> errors = std::move(pendingErrors);
+        pendingErrors.clear();
+
+        return errors;
+    }
+
+    bool Window_Global::ConsumeRequestErrors(int requestCode)
+    {
+        auto it = remove_if(
+            pendingErrors.begin(),
+            pendingErrors.end(),
+            [requestCode](const X11Error& error) { return error.requestCode == requestCode; });
+
+        bool hadErrors = it != pendingErrors.end();
+        pendingErrors.erase(it, pendingErrors.end());
+
+        return hadErrors;
+    }
+
     PopupResult Window_Global::CreatePopup(
 		string&& title,
 		string&& message,
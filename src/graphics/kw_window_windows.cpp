@@ -28,6 +28,7 @@
 
 #include "core/kw_core.hpp"
 #include "core/kw_input.hpp"
+#include "core/kw_snapshot.hpp"
 #include "graphics/kw_window_global.hpp"
 #include "graphics/kw_vulkan.hpp"
 
@@ -41,6 +42,7 @@ using KalaHeaders::KalaLog::LogType;
 using KalaWindow::Core::KalaWindowCore;
 using KalaWindow::Core::MAX_NAME_LENGTH;
 using KalaWindow::Core::Input;
+using KalaWindow::Core::StateSnapshot;
 using KalaWindow::Graphics::ProcessWindow;
 using KalaWindow::Graphics::VulkanContext;
 
@@ -71,6 +73,11 @@ namespace KalaWindow::Graphics
 {
 	static KalaWindowRegistry<ProcessWindow> registry{};
 
+	//Set while Update runs, Destroy only queues windows while this is true
+	static bool isUpdating{};
+	//Windows destroyed during Update, torn down together at the end of Update
+	static vector<u32> pendingDestroyIDs{};
+
 	KalaWindowRegistry<ProcessWindow>& ProcessWindow::GetRegistry() { return registry; }
 
 	ProcessWindow* ProcessWindow::Initialize(
@@ -117,11 +124,19 @@ namespace KalaWindow::Graphics
 			return nullptr;
 		}
 
-		u32 newID = KalaWindowCore::GetGlobalID() + 1;
-		KalaWindowCore::SetGlobalID(newID);
+		u32 newID = registry.AddContent();
+		if (newID == 0)
+		{
+			Log::Print(
+				"Failed to create window '" + newTitle + "' because the window registry is full!",
+				"KW_WINDOW",
+				LogType::LOG_ERROR,
+				2);
+
+			return nullptr;
+		}
 
-		unique_ptr<ProcessWindow> newWindow = make_unique<ProcessWindow>();
-		ProcessWindow* windowPtr = newWindow.get();
+		ProcessWindow* windowPtr = registry.GetContent(newID);
 
 		HINSTANCE newHInstance = GetModuleHandle(nullptr);
 
@@ -229,8 +244,6 @@ namespace KalaWindow::Graphics
 
 		windowPtr->BringToFocus();
 
-		registry.AddContent(newID, std::move(newWindow));
-
 		Log::Print(
 			"Created new window '" + newTitle + "' with ID '" + to_string(newID) + "'!",
 			"KW_WINDOW",
@@ -242,15 +255,39 @@ namespace KalaWindow::Graphics
 		return windowPtr;
 	}
 
+	vector<ProcessWindow*> ProcessWindow::InitializeBatch(vector<WindowCreateInfo>&& infos)
+	{
+		//window creation is synchronous on Windows, there is nothing to pipeline
+		vector<ProcessWindow*> result{};
+		result.reserve(infos.size());
+
+		for (WindowCreateInfo& info : infos)
+		{
+			result.push_back(Initialize(
+				std::move(info.title),
+				info.pos,
+				info.size,
+				info.parentWindow));
+		}
+
+		return result;
+	}
+
     void ProcessWindow::Update(
         const function<void()>& earlyGlobalUpdate,
         const function<void()>& globalUpdate,
         const function<void()>& lateGlobalUpdate)
 	{
+		isUpdating = true;
+
 		if (earlyGlobalUpdate) earlyGlobalUpdate();
 
-        for (ProcessWindow* pw : registry.GetAllContent())
+        //walk the dense hot state array by index and only load the window itself
+        //when it has a callback, destruction is deferred so windows are never removed here
+        //but callbacks and dispatched messages may add windows, which can move the hot state array
+        for (size_t i = 0; i < registry.GetAllHotContent().size(); ++i)
         {
+            ProcessWindow* pw = registry.GetAllContent()[i];
             if (!pw)
             {
                 KalaWindowCore::ForceClose(
@@ -258,7 +295,11 @@ namespace KalaWindow::Graphics
                     "Failed to update a window during window global update because it was invalid!");
             }
 
-			if (pw->earlyUpdateCallback) pw->earlyUpdateCallback();
+			if (registry.GetAllHotContent()[i].isPendingDestroy) continue;
+
+			if (registry.GetAllHotContent()[i].hasEarlyUpdateCallback) pw->earlyUpdateCallback();
+
+			if (registry.GetAllHotContent()[i].isPendingDestroy) continue;
 
 			pw->UpdateIdleState();
 
@@ -270,13 +311,19 @@ namespace KalaWindow::Graphics
 				DispatchMessage(&msg);  //send the message to the window procedure
 			}
 
-			if (pw->updateCallback) pw->updateCallback();
+			if (registry.GetAllHotContent()[i].isPendingDestroy) continue;
+
+			if (registry.GetAllHotContent()[i].hasUpdateCallback) pw->updateCallback();
         }
 
         if (globalUpdate) globalUpdate();
 
-        for (ProcessWindow* pw : registry.GetAllContent())
+        StateSnapshot::BeginCapture();
+
+        for (size_t i = 0; i < registry.GetAllHotContent().size(); ++i)
         {
+            ProcessWindow* pw = registry.GetAllContent()[i];
+
             //ensure each window is still valid after user callback
             if (!pw)
             {
@@ -286,7 +333,9 @@ namespace KalaWindow::Graphics
                     "after user callback because the window was invalid!");
             }
 
-            u32 inputID = pw->GetInputID();
+            if (registry.GetAllHotContent()[i].isPendingDestroy) continue;
+
+            u32 inputID = registry.GetAllHotContent()[i].inputID;
             Input* input = Input::GetRegistry().GetContent(inputID);
             if (!input)
             {
@@ -297,16 +346,29 @@ namespace KalaWindow::Graphics
                     + "' during window global update because the input was invalid!");
             }
 
+            //capture before input end frame update clears this frame's events
+            StateSnapshot::CaptureWindow(pw, input);
+
             input->EndFrameUpdate();
 
-			if (pw->lateUpdateCallback) pw->lateUpdateCallback();
+			if (registry.GetAllHotContent()[i].hasLateUpdateCallback) pw->lateUpdateCallback();
         }
 
+        StateSnapshot::Publish();
+
 		if (lateGlobalUpdate) lateGlobalUpdate();
+
+		isUpdating = false;
+
+		DestroyPending();
 	}
 
 	u32 ProcessWindow::GetID() const { return ID; }
-	u32 ProcessWindow::GetInputID() const { return inputID; }
+	u32 ProcessWindow::GetInputID() const
+	{
+		const WindowHotState* hot = GetHotState();
+		return hot ? hot->inputID : 0;
+	}
 	u32 ProcessWindow::GetGraphicsContextID() const { return graphicsContextID; }
 
     void ProcessWindow::SetDraggedFilesCallback(function<void(const vector<path>&, vec2)>&& newValue)
@@ -356,7 +418,7 @@ namespace KalaWindow::Graphics
 
 		return result;
 	}
-	void ProcessWindow::SetTitle(string&& newTitle) const
+	void ProcessWindow::SetTitle(string&& newTitle)
 	{
 		HWND window = ToVar<HWND>(windowData.window);
 		if (!IsWindow(window))
@@ -915,9 +977,17 @@ namespace KalaWindow::Graphics
 		}
 	}
 
-	bool ProcessWindow::IsIdle() const { return isIdle; }
+	bool ProcessWindow::IsIdle() const
+	{
+		const WindowHotState* hot = GetHotState();
+		return hot && hot->isIdle;
+	}
 
-	bool ProcessWindow::IsHovered() const { return isWindowHovered; }
+	bool ProcessWindow::IsHovered() const
+	{
+		const WindowHotState* hot = GetHotState();
+		return hot && hot->isHovered;
+	}
 	bool ProcessWindow::IsForegroundWindow() const
 	{
 		HWND window = ToVar<HWND>(windowData.window);
@@ -1007,7 +1077,11 @@ namespace KalaWindow::Graphics
 
 		return IsWindowVisible(window);
 	}
-	bool ProcessWindow::IsResizing() const { return isResizing; }
+	bool ProcessWindow::IsResizing() const
+	{
+		const WindowHotState* hot = GetHotState();
+		return hot && hot->isResizing;
+	}
 
 	WindowMode ProcessWindow::GetWindowMode()
 	{
@@ -1317,6 +1391,8 @@ namespace KalaWindow::Graphics
 		}
 
 		earlyUpdateCallback = std::move(newValue);
+
+		if (WindowHotState* hot = GetHotState()) hot->hasEarlyUpdateCallback = scast<bool>(earlyUpdateCallback);
     }
     void ProcessWindow::SetUpdateCallback(function<void()>&& newValue)
     {
@@ -1329,6 +1405,8 @@ namespace KalaWindow::Graphics
 		}
 
 		updateCallback = std::move(newValue);
+
+		if (WindowHotState* hot = GetHotState()) hot->hasUpdateCallback = scast<bool>(updateCallback);
     }
     void ProcessWindow::SetLateUpdateCallback(function<void()>&& newValue)
     {
@@ -1341,6 +1419,8 @@ namespace KalaWindow::Graphics
 		}
 
 		lateUpdateCallback = std::move(newValue);
+
+		if (WindowHotState* hot = GetHotState()) hot->hasLateUpdateCallback = scast<bool>(lateUpdateCallback);
     }
 
 	void ProcessWindow::SetResizeCallback(function<void()>&& newValue)
@@ -1371,13 +1451,72 @@ namespace KalaWindow::Graphics
 
     void ProcessWindow::UpdateIdleState()
     {
-        isIdle =
+        WindowHotState* hot = GetHotState();
+        if (!hot) return;
+
+        hot->isIdle =
             !IsForegroundWindow()
             || IsMinimized()
             || !IsVisible();
     }
 
+    WindowHotState* ProcessWindow::GetHotState() const
+    {
+        return KalaWindowRegistry<ProcessWindow>::GetHotContent(ID);
+    }
+
 	void ProcessWindow::Destroy()
+	{
+		//tearing the window down now would pull it out from under the update loops,
+		//so during Update it is only marked and queued for DestroyPending
+		if (isUpdating)
+		{
+			WindowHotState* hot = GetHotState();
+			if (!hot
+				|| hot->isPendingDestroy)
+			{
+				return;
+			}
+
+			hot->isPendingDestroy = true;
+			pendingDestroyIDs.push_back(ID);
+
+			//children go down with their parent, skip them for the rest of the frame too
+			for (u32 childID : childIDs)
+			{
+				ProcessWindow* pw = registry.GetContent(childID);
+				if (pw) pw->Destroy();
+			}
+
+			return;
+		}
+
+		DestroyNow();
+	}
+
+	bool ProcessWindow::IsPendingDestroy() const
+	{
+		const WindowHotState* hot = GetHotState();
+		return hot && hot->isPendingDestroy;
+	}
+
+	void ProcessWindow::DestroyPending()
+	{
+		if (pendingDestroyIDs.empty()) return;
+
+		//a shutdown callback may destroy more windows, those are torn down right away
+		vector<u32> destroyIDs = std::move(pendingDestroyIDs);
+		pendingDestroyIDs.clear();
+
+		//parents tear down their own children, so queued children may already be gone
+		for (u32 destroyID : destroyIDs)
+		{
+			ProcessWindow* pw = registry.GetContent(destroyID);
+			if (pw) pw->DestroyNow();
+		}
+	}
+
+	void ProcessWindow::DestroyNow()
 	{
 		if (registry.GetAllContent().size() == 1)
 		{
@@ -1443,7 +1582,6 @@ namespace KalaWindow::Graphics
 			"KW_WINDOW",
 			LogType::LOG_INFO);
 
-		inputID = 0;
 		graphicsContextID = 0;
 
 		HWND hwnd = ToVar<HWND>(windowData.window);
@@ -11,6 +11,8 @@
 #include <X11/Xatom.h>
 #include <X11/Xutil.h>
 #include <X11/X.h>
+#include <X11/extensions/sync.h>
+#include <X11/extensions/Xpresent.h>
 
 #include <unistd.h>
 #include <memory>
@@ -22,8 +24,11 @@
 
 #include "core/kw_core.hpp"
 #include "core/kw_input.hpp"
+#include "core/kw_snapshot.hpp"
+#include "core/kw_gamepad.hpp"
 #include "graphics/kw_window_global.hpp"
 #include "graphics/kw_vulkan.hpp"
+#include "graphics/kw_software.hpp"
 #include "core/kw_messageloop_x11.hpp"
 
 using KalaHeaders::KalaCore::ToVar;
@@ -35,14 +40,26 @@ using KalaHeaders::KalaLog::LogType;
 using KalaWindow::Core::KalaWindowCore;
 using KalaWindow::Core::MAX_NAME_LENGTH;
 using KalaWindow::Core::Input;
+using KalaWindow::Core::StateSnapshot;
+using KalaWindow::Core::Gamepad;
 using KalaWindow::Graphics::VulkanContext;
+using KalaWindow::Graphics::SoftwareFramebuffer;
 using KalaWindow::Graphics::ProcessWindow;
 using KalaWindow::Graphics::X11GlobalData;
+using KalaWindow::Graphics::Window_Global;
+using KalaWindow::Graphics::MonitorData;
 using KalaWindow::Graphics::WindowMode;
 using KalaWindow::Graphics::WindowState;
+using KalaWindow::Graphics::PopupWindowType;
+using KalaWindow::Graphics::CompositorBypass;
+using KalaWindow::Graphics::WindowRect;
+using KalaWindow::Graphics::CompositorFrameTiming;
+using KalaWindow::Graphics::PresentTiming;
 using KalaWindow::Core::MessageLoop;
 
 using std::make_unique;
+using std::min;
+using std::max;
 using std::unique_ptr;
 using std::to_string;
 using std::string;
@@ -53,6 +70,12 @@ static int XRESULT{};
 static constexpr int SUCCESS_XGETWINDOWPROPERTY = 0;
 static constexpr int SUCCESS_XSENDEVENT = 1;
 
+//a sync frame that is never presented must not leave the counter odd and the WM waiting on it
+static constexpr u64 SYNC_FRAME_TIMEOUT = 500'000'000; //500ms in nanoseconds
+
+//a compositor that stopped answering (restarted, or unredirected this window) must not stall it forever
+static constexpr u64 COMPOSITOR_WAIT_TIMEOUT = 100'000'000; //100ms in nanoseconds
+
 static void ForceClose(
     string&& action,
     string&& reason)
@@ -62,10 +85,33 @@ static void ForceClose(
         "Failed to " + std::move(action) + " because " + std::move(reason));
 }
 
+//Returns the _NET_WM_WINDOW_TYPE atom compositors use to stack and animate this kind of popup
+static uintptr_t GetPopupWindowTypeAtom(PopupWindowType type)
+{
+    const X11GlobalData& globalData = Window_Global::GetGlobalData();
+
+    switch (type)
+    {
+    case PopupWindowType::POPUPWINDOW_DROPDOWN_MENU: return globalData.atom_net_wm_window_type_dropdown_menu;
+    case PopupWindowType::POPUPWINDOW_POPUP_MENU:    return globalData.atom_net_wm_window_type_popup_menu;
+    case PopupWindowType::POPUPWINDOW_COMBO:         return globalData.atom_net_wm_window_type_combo;
+    default:                                         return globalData.atom_net_wm_window_type_tooltip;
+    }
+}
+
 namespace KalaWindow::Graphics
 {
 	static KalaWindowRegistry<ProcessWindow> registry{};
 
+	//Set while Update runs, Destroy only queues windows while this is true
+	static bool isUpdating{};
+	//Windows destroyed during Update, torn down together at the end of Update
+	static vector<u32> pendingDestroyIDs{};
+	//Windows with queued changes, sent together at the end of Update
+	static vector<u32> changedWindowIDs{};
+	//Hidden windows waiting to be handed out by AcquirePooledWindow
+	static vector<u32> pooledWindowIDs{};
+
 	KalaWindowRegistry<ProcessWindow>& ProcessWindow::GetRegistry() { return registry; }
 
     ProcessWindow* ProcessWindow::Initialize(
@@ -73,6 +119,65 @@ namespace KalaWindow::Graphics
 		vec2 pos,
 		vec2 size,
 		ProcessWindow* parentWindow)
+    {
+        ProcessWindow* windowPtr = SendCreateRequests(
+            std::move(title),
+            pos,
+            size,
+            parentWindow);
+
+        if (!windowPtr) return nullptr;
+
+        Display* display = ToVar<Display*>(Window_Global::GetGlobalData().display);
+
+        //flush now and detect errors via ErrorHandler
+        XSync(display, False);
+
+        //title and class were cached by their setters, the rest is owned by the WM
+        //and stays current from PropertyNotify after this
+        windowPtr->UpdateResizableState();
+        windowPtr->UpdateFullscreenAndMinimizedState();
+
+        windowPtr->BringToFocus();
+
+        windowPtr->FinishInitialize();
+
+		return windowPtr;
+    }
+
+    vector<ProcessWindow*> ProcessWindow::InitializeBatch(vector<WindowCreateInfo>&& infos)
+    {
+        vector<ProcessWindow*> result{};
+        result.reserve(infos.size());
+
+        //no syncs or property reads in between, the server handles every window
+        //from one flush and the WM reports their properties back through PropertyNotify
+        for (WindowCreateInfo& info : infos)
+        {
+            result.push_back(SendCreateRequests(
+                std::move(info.title),
+                info.pos,
+                info.size,
+                info.parentWindow));
+        }
+
+        Display* display = ToVar<Display*>(Window_Global::GetGlobalData().display);
+        if (display) XFlush(display);
+
+        for (ProcessWindow* windowPtr : result)
+        {
+            if (windowPtr) windowPtr->FinishInitialize();
+        }
+
+        return result;
+    }
+
+    ProcessWindow* ProcessWindow::SendCreateRequests(
+		string&& title,
+		vec2 pos,
+		vec2 size,
+		ProcessWindow* parentWindow,
+        bool isPooled)
     {
 		if (title.empty()
             || title.size() > MAX_NAME_LENGTH)
@@ -120,22 +225,42 @@ namespace KalaWindow::Graphics
                 "the attached display was invalid!");
         }
 
-        u32 newID = KalaWindowCore::GetGlobalID() + 1;
-		KalaWindowCore::SetGlobalID(newID);
+        u32 newID = registry.AddContent();
+		if (newID == 0)
+		{
+			Log::Print(
+				"Failed to create window '" + newTitle + "' because the window registry is full!",
+				"KW_WINDOW",
+				LogType::LOG_ERROR,
+				2);
+
+			return nullptr;
+		}
 
-		unique_ptr<ProcessWindow> newWindow = make_unique<ProcessWindow>();
-		ProcessWindow* windowPtr = newWindow.get();
+		ProcessWindow* windowPtr = registry.GetContent(newID);
 
         Display* display = ToVar<Display*>(globalData.display);
 
         Window root = ToVar<Window>(globalData.window_root);
 
-        XIM xim = ToVar<XIM>(globalData.xim);
+        //errors reported for any request from here on belong to this window
+        windowPtr->firstRequestSerial = scast<u64>(NextRequest(display));
 
         XSetWindowAttributes attrs{};
         attrs.background_pixmap = None;
         attrs.border_pixel = 0;
 
+        unsigned long attrMask = CWBackPixmap | CWBorderPixel;
+
+        //pooled windows are handed out as tooltips and menus, override redirect keeps the WM
+        //from decorating, placing and focusing them just like InitializePopup does
+        if (isPooled)
+        {
+            attrs.override_redirect = True;
+            attrs.save_under = True;
+            attrMask |= CWOverrideRedirect | CWSaveUnder;
+        }
+
         Window window = XCreateWindow(
             display,
             root,
@@ -147,27 +272,9 @@ namespace KalaWindow::Graphics
             CopyFromParent,
             InputOutput,
             CopyFromParent,
-            CWBackPixmap | CWBorderPixel,
+            attrMask,
             &attrs);
 
-        //flush now and detect errors via ErrorHandler
-        XSync(display, False);
-
-        XIC xic = XCreateIC(
-            xim,
-            XNInputStyle,
-            XIMPreeditNothing | XIMStatusNothing,
-            XNClientWindow, window,
-            XNFocusWindow, window,
-            nullptr);
-
-        if (!xic)
-        {
-            ForceClose(
-                "create window '" + newTitle + "'",
-                "XCreateIC failed!");
-        }
-
         //set task manager title via PID
         u32 pid = scast<u32>(getpid());
         Atom pidAtom = ToVar<Atom>(globalData.atom_net_wm_pid);
@@ -204,11 +311,18 @@ namespace KalaWindow::Graphics
                 2);
         }
 
+        //the WM only sends sync requests to windows that list the protocol and have counters
+        Atom protocols[2] =
+        {
+            atom_wm_delete,
+            ToVar<Atom>(globalData.atom_net_wm_sync_request)
+        };
+
         XSetWMProtocols(
             display,
             window,
-            &atom_wm_delete,
-            1);
+            protocols,
+            globalData.hasSync ? 2 : 1);
 
         //allow events
         XSelectInput(
@@ -229,7 +343,6 @@ namespace KalaWindow::Graphics
         WindowData newWindowStruct{};
 
         newWindowStruct.window = FromVar(window);
-        newWindowStruct.xic = FromVar(xic);
 
         windowPtr->windowData = newWindowStruct;
 
@@ -244,6 +357,48 @@ namespace KalaWindow::Graphics
 		windowPtr->oldPos = pos;
 		windowPtr->oldSize = size;
 
+        if (globalData.hasSync)
+        {
+            XSyncValue zero{};
+            XSyncIntToValue(&zero, 0);
+
+            XSyncCounter counter = XSyncCreateCounter(display, zero);
+            XSyncCounter extendedCounter = XSyncCreateCounter(display, zero);
+
+            //listing both counters opts into the extended frame drawn and frame timings messages
+            unsigned long counters[2] =
+            {
+                counter,
+                extendedCounter
+            };
+
+            XChangeProperty(
+                display,
+                window,
+                ToVar<Atom>(globalData.atom_net_wm_sync_request_counter),
+                XA_CARDINAL,
+                32,
+                PropModeReplace,
+                rcast<unsigned char*>(counters),
+                2);
+
+            windowPtr->syncCounter = FromVar(counter);
+            windowPtr->extendedSyncCounter = FromVar(extendedCounter);
+        }
+
+        //every present on this window is reported, including the ones made by the Vulkan driver,
+        //the selection goes away with the window
+        if (globalData.hasPresent)
+        {
+            XID presentEventID = XPresentSelectInput(
+                display,
+                window,
+                PresentCompleteNotifyMask
+                | PresentIdleNotifyMask);
+
+            windowPtr->presentEventID = FromVar(presentEventID);
+        }
+
         if (parentWindow)
         {
             const vector<ProcessWindow*>& content = registry.GetAllContent();
@@ -271,8 +426,9 @@ namespace KalaWindow::Graphics
 			windowPtr->parentID = parentWindow->ID;
         }
 
-        //do not display child window in taskbar
-        if (windowPtr->parentID != UINT32_MAX)
+        //do not display child or pooled windows in taskbar
+        if (windowPtr->parentID != UINT32_MAX
+            || isPooled)
         {
             Atom skipTaskbar = ToVar<Atom>(globalData.atom_net_wm_state_skip_taskbar);
 
@@ -329,198 +485,748 @@ namespace KalaWindow::Graphics
             rcast<const unsigned char*>(&netWmWindowTypeNormal),
             1);
 
-        //show window
-        XMapWindow(
-            display,
-            window);
-
-        //flush now and detect errors via ErrorHandler
-        XSync(display, False);
-
-        windowPtr->BringToFocus();
-
-		registry.AddContent(newID, std::move(newWindow));
-
-		Log::Print(
-			"Created new window '" + newTitle + "' with ID '" + to_string(newID) + "'!",
-			"KW_WINDOW",
-			LogType::LOG_SUCCESS);
+        //show window, pooled windows stay unmapped until they are acquired
+        if (!isPooled)
+        {
+            XMapWindow(
+                display,
+                window);
+        }
 
-        Input::Initialize(windowPtr->ID);
-        VulkanContext::InitializeInstance(windowPtr->ID);
+        windowPtr->lastRequestSerial = scast<u64>(NextRequest(display)) - 1;
 
 		return windowPtr;
     }
 
-    void ProcessWindow::Update(
-        const function<void()>& earlyGlobalUpdate,
-        const function<void()>& globalUpdate,
-        const function<void()>& lateGlobalUpdate)
-	{
-        if (earlyGlobalUpdate) earlyGlobalUpdate();
-
-        //X11 requires a message loop update that is separate from each process window
-        MessageLoop::Update();
+    void ProcessWindow::FillWindowPool(u32 count)
+    {
+        vector<ProcessWindow*> created{};
+        created.reserve(count);
 
-        for (ProcessWindow* pw : registry.GetAllContent())
+        for (u32 i = 0; i < count; ++i)
         {
-            if (!pw)
-            {
-                KalaWindowCore::ForceClose(
-                    "KalaWindow window error",
-                    "Failed to update a window during window global update because it was invalid!");
-            }
+            ProcessWindow* windowPtr = SendCreateRequests(
+                "popup",
+                0,
+                MIN_WINDOW_SIZE,
+                nullptr,
+                true);
 
-            if (pw->earlyUpdateCallback) pw->earlyUpdateCallback();
+            if (!windowPtr) break;
 
-            pw->UpdateIdleState();
+            //tooltips and menus are often smaller than a regular window may be
+            windowPtr->minSize = vec2{ 1, 1 };
 
-            if (pw->updateCallback) pw->updateCallback();
+            created.push_back(windowPtr);
         }
 
-        if (globalUpdate) globalUpdate();
+        Display* display = ToVar<Display*>(Window_Global::GetGlobalData().display);
+        if (display) XFlush(display);
 
-        for (ProcessWindow* pw : registry.GetAllContent())
+        for (ProcessWindow* windowPtr : created)
         {
-            //ensure each window is still valid after user callback
-            if (!pw)
-            {
-                KalaWindowCore::ForceClose(
-                    "KalaWindow window error",
-                    "Failed to update a window during window global update "
-                    "after user callback because the window was invalid!");
-            }
+            windowPtr->FinishInitialize();
 
-            u32 inputID = pw->GetInputID();
-            Input* input = Input::GetRegistry().GetContent(inputID);
-            if (!input)
+            if (WindowHotState* hot = windowPtr->GetHotState())
             {
-                KalaWindowCore::ForceClose(
-                    "KalaWindow window error",
-                    "Failed to update input '" + to_string(inputID) 
-                    + "' under window '" + to_string(pw->GetID()) 
-                    + "' during window global update because its input '" + to_string(inputID) + "' was invalid!");
+                hot->isPooled = true;
+                hot->isPopup = true;
             }
-
-            input->EndFrameUpdate();
-
-            if (pw->lateUpdateCallback) pw->lateUpdateCallback();
+            pooledWindowIDs.push_back(windowPtr->ID);
         }
-
-        if (lateGlobalUpdate) lateGlobalUpdate();
     }
 
-	u32 ProcessWindow::GetID() const { return ID; }
-    u32 ProcessWindow::GetInputID() const { return inputID; }
-	u32 ProcessWindow::GetGraphicsContextID() const { return graphicsContextID; }
+    u32 ProcessWindow::GetWindowPoolSize() { return scast<u32>(pooledWindowIDs.size()); }
 
-    void ProcessWindow::SetDraggedFilesCallback(function<void(const vector<path>&, vec2)>&& newValue)
+    ProcessWindow* ProcessWindow::AcquirePooledWindow(
+        vec2 pos,
+        vec2 size,
+        ProcessWindow* parentWindow,
+        PopupWindowType type)
     {
-        if (!newValue)
-		{
-			Log::Print(
-				"Failed to assign window '" + to_string(ID) + "' dragged files callback because it was empty!",
-				"KW_WINDOW",
-				LogType::LOG_ERROR,
-				2);
+        if (pooledWindowIDs.empty())
+        {
+            if (Window_Global::IsVerboseLoggingEnabled())
+            {
+                Log::Print(
+                    "Window pool is empty, creating a new pooled window.",
+                    "KW_WINDOW",
+                    LogType::LOG_VERBOSE);
+            }
 
-			return;
-		}
+            FillWindowPool(1);
+            if (pooledWindowIDs.empty()) return nullptr;
+        }
 
-		draggedFilesCallback = std::move(newValue);
-    }
-	const vector<path>& ProcessWindow::GetLastDraggedFiles() const { return lastDraggedFiles; };
-	void ProcessWindow::ClearLastDraggedFiles() { lastDraggedFiles.clear(); };
+        u32 windowID = pooledWindowIDs.back();
+        pooledWindowIDs.pop_back();
 
-    string ProcessWindow::GetTitle() const
-    {
-        const X11GlobalData& globalData = Window_Global::GetGlobalData();
-        if (!globalData.display)
+        ProcessWindow* windowPtr = registry.GetContent(windowID);
+        WindowHotState* hot = windowPtr ? windowPtr->GetHotState() : nullptr;
+        if (!hot)
         {
 			ForceClose(
-				"get window '" + to_string(ID) + "' title",
-                "the display handle was invalid!");
+				"acquire pooled window '" + to_string(windowID) + "'",
+                "the pooled window was invalid!");
+        }
+
+        hot->isPooled = false;
+
+        if (parentWindow)
+        {
+			parentWindow->childIDs.push_back(windowID);
+			windowPtr->parentID = parentWindow->ID;
         }
 
+        vec2 newSize = kclamp(size, windowPtr->minSize, windowPtr->maxSize);
+
+        windowPtr->oldPos = pos;
+        windowPtr->oldSize = newSize;
+
+        const X11GlobalData& globalData = Window_Global::GetGlobalData();
+
         Display* display = ToVar<Display*>(globalData.display);
-        Window window = ToVar<Window>(windowData.window);
+        Window window = ToVar<Window>(windowPtr->windowData.window);
 
-        Atom atom_utf8 = ToVar<Atom>(globalData.atom_utf8);
-        Atom atom_net_wm_name = ToVar<Atom>(globalData.atom_net_wm_name);
+        //compositors still read the owner and type to stack, shadow and animate popups
+        if (parentWindow)
+        {
+            XSetTransientForHint(
+                display,
+                window,
+                ToVar<Window>(parentWindow->windowData.window));
+        }
 
-        Atom actualType{};
-        int actualFormat{};
-        unsigned long nItems{};
-        unsigned long bytesAfter{};
-        unsigned char* prop{};
+        Atom windowType = ToVar<Atom>(GetPopupWindowTypeAtom(type));
 
-        string title{};
+        XChangeProperty(
+            display,
+            window,
+            ToVar<Atom>(globalData.atom_net_wm_window_type),
+            XA_ATOM,
+            32,
+            PropModeReplace,
+            rcast<const unsigned char*>(&windowType),
+            1);
 
-        XRESULT = XGetWindowProperty(
+        //sent with the flush at the end of Update or by the next XPending in the message loop
+        XMoveResizeWindow(
             display,
             window,
-            atom_net_wm_name,
-            0,
-            (~0L),
-            False,
-            atom_utf8,
-            &actualType,
-            &actualFormat,
-            &nItems,
-            &bytesAfter,
-            &prop);
+            scast<int>(pos.x),
+            scast<int>(pos.y),
+            scast<u32>(newSize.x),
+            scast<u32>(newSize.y));
+        XMapRaised(display, window);
 
-        if (XRESULT != SUCCESS_XGETWINDOWPROPERTY)
+        return windowPtr;
+    }
+
+    void ProcessWindow::ReleaseToPool()
+    {
+        WindowHotState* hot = GetHotState();
+        if (!hot
+            || hot->isPooled
+            || hot->isPendingDestroy)
         {
-			ForceClose(
-				"get window '" + to_string(ID) + " title",
-                "XGetWindowProperty failed! Result code: " + to_string(XRESULT));
+            return;
         }
 
-        if (!prop)
+        vector<u32> children = std::move(childIDs);
+        childIDs.clear();
+        for (u32 childID : children)
         {
-            Log::Print(
-                "Failed to get window '" + to_string(ID) + "' title because prop was invalid!",
-                "KW_WINDOW",
-                LogType::LOG_ERROR,
-                2);
+            ProcessWindow* pw = registry.GetContent(childID);
+            if (pw) pw->Destroy();
         }
 
-        title.assign(rcast<char*>(prop), nItems);
-        XFree(prop);
-
-        return title;
-    }
-    void ProcessWindow::SetTitle(string&& newValue) const
-    {
-        const X11GlobalData& globalData = Window_Global::GetGlobalData();
-        if (!globalData.display)
+        if (parentID != UINT32_MAX)
         {
-			ForceClose(
-				"set window '" + to_string(ID) + "' title",
-                "the display handle was invalid!");
+			ProcessWindow* pw = registry.GetContent(parentID);
+			if (pw)
+			{
+				auto it = find(pw->childIDs.begin(), pw->childIDs.end(), ID);
+				if (it != pw->childIDs.end()) pw->childIDs.erase(it);
+			}
+
+            parentID = UINT32_MAX;
         }
 
-		if (newValue.empty()
-            || newValue.length() > MAX_NAME_LENGTH)
-		{
-			Log::Print(
-				"Failed to set window '" + to_string(ID) + "' title "
-                "because the new title is empty or too long!",
-				"KW_WINDOW",
-				LogType::LOG_ERROR,
-				2);
+        //the next user of this window starts from a clean slate
+        earlyUpdateCallback = {};
+        updateCallback = {};
+        lateUpdateCallback = {};
+        resizeCallback = {};
+        shutdownCallback = {};
+        draggedFilesCallback = {};
+        errorCallback = {};
 
-			return;
-		}
+        lastDraggedFiles.clear();
 
-        string value(newValue);
-        Display* display = ToVar<Display*>(globalData.display);
+        for (Input* input : Input::GetRegistry().GetAllWindowContent(ID))
+        {
+            input->ClearInputEvents(true);
+        }
 
-        Atom net_wm_name = ToVar<Atom>(globalData.atom_net_wm_name);
-        Atom utf8 = ToVar<Atom>(globalData.atom_utf8);
+        hot = GetHotState();
+        hot->hasEarlyUpdateCallback = false;
+        hot->hasUpdateCallback = false;
+        hot->hasLateUpdateCallback = false;
+        hot->isPooled = true;
 
-        XStoreName(
+        //graphics of the last user draw its contents, the next user creates its own
+        KalaWindowRegistry<VulkanContext>::RemoveAllWindowContent(ID);
+        KalaWindowRegistry<SoftwareFramebuffer>::RemoveAllWindowContent(ID);
+        graphicsContextID = 0;
+
+        //queued changes and cached state of the last user are dropped with it
+        if (windowMode == WindowMode::WINDOWMODE_EXCLUSIVE) RestoreExclusiveDisplayMode();
+        exclusiveSize = {};
+        exclusiveRefreshRate = 0.0f;
+
+        bool isQueued = pendingChanges.isQueued;
+        pendingChanges = {};
+        pendingChanges.isQueued = isQueued;
+
+        windowMode = WindowMode::WINDOWMODE_WINDOWED;
+        windowState = WindowState::WINDOW_NORMAL;
+        isAlwaysOnTop = false;
+        isFullscreen = false;
+
+        minSize = vec2{ 1, 1 };
+        maxSize = vec2{ DEFAULT_MAX_WINDOW_WIDTH, DEFAULT_MAX_WINDOW_HEIGHT };
+
+        //these rewrite their properties, isFullscreen must already be reset
+        ResetOpaqueRegion();
+        SetCompositorBypass(CompositorBypass::COMPOSITOR_BYPASS_FULLSCREEN);
+        SetVariableRefreshState(false);
+
+        damageRects.clear();
+        isFullyDamaged = false;
+        isDamageTracked = false;
+
+        //a frame left odd would keep the WM waiting while the window sits in the pool,
+        //the counter values themselves only ever grow
+        if (syncFrameID != 0) FinishSyncFrame();
+        isSyncRequestPending = false;
+        isSyncConfigurePending = false;
+        isSyncFrameResize = false;
+        hasSyncFrames = false;
+        isWaitingForCompositor = false;
+        hasCompositorFrameDrawn = false;
+        lastCompositorFrameTiming = {};
+        lastPresentTiming = {};
+
+        Display* display = ToVar<Display*>(Window_Global::GetGlobalData().display);
+        Window window = ToVar<Window>(windowData.window);
+
+        if (title != "popup") SetTitle("popup");
+
+        XDeleteProperty(
+            display,
+            window,
+            XA_WM_TRANSIENT_FOR);
+
+        XUnmapWindow(display, window);
+
+        pooledWindowIDs.push_back(ID);
+    }
+
+    ProcessWindow* ProcessWindow::InitializePopup(
+        PopupWindowType type,
+        vec2 offset,
+        vec2 size,
+        ProcessWindow* parentWindow)
+    {
+        if (!parentWindow
+            || registry.GetContent(parentWindow->ID) != parentWindow)
+        {
+			Log::Print(
+				"Failed to create popup window because its parent window was invalid!",
+				"KW_WINDOW",
+				LogType::LOG_ERROR,
+				2);
+
+			return nullptr;
+        }
+
+        if (size.x < 1.0f
+            || size.y < 1.0f
+            || size > MAX_WINDOW_SIZE)
+        {
+			Log::Print(
+				"Failed to create popup window for window '" + to_string(parentWindow->ID) 
+                + "' because its size was invalid!",
+				"KW_WINDOW",
+				LogType::LOG_ERROR,
+				2);
+
+			return nullptr;
+        }
+
+        const X11GlobalData& globalData = Window_Global::GetGlobalData();
+        if (!globalData.display)
+        {
+            ForceClose(
+                "create popup window for window '" + to_string(parentWindow->ID) + "'",
+                "the attached display was invalid!");
+        }
+
+        u32 newID = registry.AddContent();
+		if (newID == 0)
+		{
+			Log::Print(
+				"Failed to create popup window for window '" + to_string(parentWindow->ID) 
+                + "' because the window registry is full!",
+				"KW_WINDOW",
+				LogType::LOG_ERROR,
+				2);
+
+			return nullptr;
+		}
+
+		ProcessWindow* windowPtr = registry.GetContent(newID);
+
+        Display* display = ToVar<Display*>(globalData.display);
+        Window root = ToVar<Window>(globalData.window_root);
+        Window parentWindowRef = ToVar<Window>(parentWindow->windowData.window);
+
+        //pos is kept relative to the root even for reparented windows, so this needs no round trip
+        vec2 pos = vec2(
+            parentWindow->pos.x + offset.x,
+            parentWindow->pos.y + offset.y);
+
+        windowPtr->firstRequestSerial = scast<u64>(NextRequest(display));
+
+        //override redirect keeps the WM out, save under lets the server
+        //restore what was below a tooltip without asking the owner to redraw
+        XSetWindowAttributes attrs{};
+        attrs.override_redirect = True;
+        attrs.save_under = True;
+        attrs.background_pixmap = None;
+        attrs.border_pixel = 0;
+
+        Window window = XCreateWindow(
+            display,
+            root,
+            scast<int>(pos.x),
+            scast<int>(pos.y),
+            scast<u32>(size.x),
+            scast<u32>(size.y),
+            0,
+            CopyFromParent,
+            InputOutput,
+            CopyFromParent,
+            CWOverrideRedirect | CWSaveUnder | CWBackPixmap | CWBorderPixel,
+            &attrs);
+
+        //compositors still read the owner and type to stack, shadow and animate popups
+        XSetTransientForHint(
+            display,
+            window,
+            parentWindowRef);
+
+        Atom windowType = ToVar<Atom>(GetPopupWindowTypeAtom(type));
+
+        XChangeProperty(
+            display,
+            window,
+            ToVar<Atom>(globalData.atom_net_wm_window_type),
+            XA_ATOM,
+            32,
+            PropModeReplace,
+            rcast<const unsigned char*>(&windowType),
+            1);
+
+        //popups never get keyboard focus, keys keep going to the parent window
+        XSelectInput(
+            display,
+            window,
+            ExposureMask
+            | StructureNotifyMask
+            | EnterWindowMask
+            | LeaveWindowMask
+            | ButtonPressMask
+            | ButtonReleaseMask
+            | PointerMotionMask);
+
+        //software framebuffers on popups are paced by Present just like on regular windows
+        if (globalData.hasPresent)
+        {
+            XID presentEventID = XPresentSelectInput(
+                display,
+                window,
+                PresentCompleteNotifyMask
+                | PresentIdleNotifyMask);
+
+            windowPtr->presentEventID = FromVar(presentEventID);
+        }
+
+        XMapRaised(display, window);
+
+        windowPtr->lastRequestSerial = scast<u64>(NextRequest(display)) - 1;
+
+        XFlush(display);
+
+        windowPtr->ID = newID;
+        windowPtr->windowData.window = FromVar(window);
+
+        windowPtr->title = "popup";
+
+        windowPtr->pos = pos;
+        windowPtr->size = size;
+        windowPtr->outerSize = size;
+        windowPtr->oldPos = pos;
+        windowPtr->oldSize = size;
+
+        //popups are often smaller than a regular window may be
+        windowPtr->minSize = vec2{ 1, 1 };
+
+        parentWindow->childIDs.push_back(newID);
+        windowPtr->parentID = parentWindow->ID;
+
+        if (WindowHotState* hot = windowPtr->GetHotState()) hot->isPopup = true;
+
+        windowPtr->FinishInitialize();
+
+        return windowPtr;
+    }
+
+    bool ProcessWindow::IsPopup() const
+    {
+        const WindowHotState* hot = GetHotState();
+        return hot && hot->isPopup;
+    }
+
+    const MonitorData* ProcessWindow::GetMonitor() const
+    {
+        const MonitorData* result{};
+        i64 largestOverlap{};
+
+        //the frame the user sees decides the monitor, pos is root relative so no round trip is needed.
+        //Before the first ConfigureNotify there is no frame yet and the requested geometry is used
+        vec2 frameSize = outerSize.x > 0.0f
+            ? outerSize
+            : size;
+
+        i64 left = scast<i64>(pos.x - frameOffset.x);
+        i64 top = scast<i64>(pos.y - frameOffset.y);
+        i64 right = left + scast<i64>(frameSize.x);
+        i64 bottom = top + scast<i64>(frameSize.y);
+
+        for (const MonitorData& monitor : Window_Global::GetMonitors())
+        {
+            i64 overlapX =
+                min(right, scast<i64>(monitor.x) + monitor.width)
+                - max(left, scast<i64>(monitor.x));
+            i64 overlapY =
+                min(bottom, scast<i64>(monitor.y) + monitor.height)
+                - max(top, scast<i64>(monitor.y));
+
+            if (overlapX <= 0
+                || overlapY <= 0)
+            {
+                continue;
+            }
+
+            i64 overlap = overlapX * overlapY;
+            if (overlap > largestOverlap)
+            {
+                largestOverlap = overlap;
+                result = &monitor;
+            }
+        }
+
+        return result;
+    }
+
+    void ProcessWindow::FinishInitialize()
+    {
+        UpdateOpaqueRegion();
+
+		Log::Print(
+			"Created new window '" + title + "' with ID '" + to_string(ID) + "'!",
+			"KW_WINDOW",
+			LogType::LOG_SUCCESS);
+
+        Input::Initialize(ID);
+        VulkanContext::InitializeInstance(ID);
+    }
+
+    void ProcessWindow::CreateInputContext()
+    {
+        if (windowData.xic) return;
+
+        const X11GlobalData& globalData = Window_Global::GetGlobalData();
+        if (!globalData.display
+            || !globalData.xim)
+        {
+            return;
+        }
+
+        Window window = ToVar<Window>(windowData.window);
+
+        XIC xic = XCreateIC(
+            ToVar<XIM>(globalData.xim),
+            XNInputStyle,
+            XIMPreeditNothing | XIMStatusNothing,
+            XNClientWindow, window,
+            XNFocusWindow, window,
+            nullptr);
+
+        if (!xic)
+        {
+			Log::Print(
+				"Failed to create input context for window '" + to_string(ID) + "', "
+                "text input falls back to plain key lookup!",
+				"KW_WINDOW",
+				LogType::LOG_ERROR,
+				2);
+
+            return;
+        }
+
+        windowData.xic = FromVar(xic);
+    }
+
+    void ProcessWindow::DispatchErrors()
+    {
+        vector<X11Error> errors = Window_Global::ConsumeErrors();
+
+        for (const X11Error& error : errors)
+        {
+            for (ProcessWindow* pw : registry.GetAllContent())
+            {
+                bool isOwner =
+                    error.resourceID == pw->windowData.window
+                    || (error.serial >= pw->firstRequestSerial
+                    && error.serial <= pw->lastRequestSerial);
+
+                if (!isOwner) continue;
+
+                if (pw->errorCallback) pw->errorCallback(error);
+                break;
+            }
+        }
+    }
+
+    void ProcessWindow::Update(
+        const function<void()>& earlyGlobalUpdate,
+        const function<void()>& globalUpdate,
+        const function<void()>& lateGlobalUpdate)
+	{
+        isUpdating = true;
+
+        if (earlyGlobalUpdate) earlyGlobalUpdate();
+
+        //X11 requires a message loop update that is separate from each process window
+        MessageLoop::Update();
+
+        //errors from the previous frame's requests arrived while the message loop read events
+        DispatchErrors();
+
+        Gamepad::Update();
+
+        //walk the dense hot state array by index and only load the window itself
+        //when it has a callback, destruction is deferred so windows are never removed here
+        //but callbacks may add windows, which can move the hot state array
+        for (size_t i = 0; i < registry.GetAllHotContent().size(); ++i)
+        {
+            ProcessWindow* pw = registry.GetAllContent()[i];
+            if (!pw)
+            {
+                KalaWindowCore::ForceClose(
+                    "KalaWindow window error",
+                    "Failed to update a window during window global update because it was invalid!");
+            }
+
+            if (registry.GetAllHotContent()[i].isPendingDestroy
+                || registry.GetAllHotContent()[i].isPooled)
+            {
+                continue;
+            }
+
+            if (registry.GetAllHotContent()[i].hasEarlyUpdateCallback) pw->earlyUpdateCallback();
+
+            WindowHotState& hot = registry.GetAllHotContent()[i];
+            if (hot.isPendingDestroy
+                || hot.isPooled)
+            {
+                continue;
+            }
+
+            hot.isIdle =
+                (!hot.isFocused
+                && !hot.isPopup)
+                || hot.isMinimized
+                || !hot.isVisible;
+
+            if (hot.hasUpdateCallback) pw->updateCallback();
+        }
+
+        if (globalUpdate) globalUpdate();
+
+        StateSnapshot::BeginCapture();
+
+        for (size_t i = 0; i < registry.GetAllHotContent().size(); ++i)
+        {
+            ProcessWindow* pw = registry.GetAllContent()[i];
+
+            //ensure each window is still valid after user callback
+            if (!pw)
+            {
+                KalaWindowCore::ForceClose(
+                    "KalaWindow window error",
+                    "Failed to update a window during window global update "
+                    "after user callback because the window was invalid!");
+            }
+
+            if (registry.GetAllHotContent()[i].isPendingDestroy
+                || registry.GetAllHotContent()[i].isPooled)
+            {
+                continue;
+            }
+
+            u32 inputID = registry.GetAllHotContent()[i].inputID;
+            Input* input = Input::GetRegistry().GetContent(inputID);
+            if (!input)
+            {
+                KalaWindowCore::ForceClose(
+                    "KalaWindow window error",
+                    "Failed to update input '" + to_string(inputID) 
+                    + "' under window '" + to_string(pw->GetID()) 
+                    + "' during window global update because its input '" + to_string(inputID) + "' was invalid!");
+            }
+
+            //capture before input end frame update clears this frame's events
+            StateSnapshot::CaptureWindow(pw, input);
+
+            input->EndFrameUpdate();
+
+            if (registry.GetAllHotContent()[i].hasLateUpdateCallback) pw->lateUpdateCallback();
+        }
+
+        StateSnapshot::Publish();
+
+        if (lateGlobalUpdate) lateGlobalUpdate();
+
+        isUpdating = false;
+
+        SendAllSyncCounters();
+        SendAllPendingChanges();
+        DestroyPending();
+
+        //one flush for every window change and teardown of this frame
+        Display* display = ToVar<Display*>(Window_Global::GetGlobalData().display);
+        if (display) XFlush(display);
+    }
+
+	u32 ProcessWindow::GetID() const { return ID; }
+    u32 ProcessWindow::GetInputID() const
+    {
+        const WindowHotState* hot = GetHotState();
+        return hot ? hot->inputID : 0;
+    }
+	u32 ProcessWindow::GetGraphicsContextID() const { return graphicsContextID; }
+
+    void ProcessWindow::SetDraggedFilesCallback(function<void(const vector<path>&, vec2)>&& newValue)
+    {
+        if (!newValue)
+		{
+			Log::Print(
+				"Failed to assign window '" + to_string(ID) + "' dragged files callback because it was empty!",
+				"KW_WINDOW",
+				LogType::LOG_ERROR,
+				2);
+
+			return;
+		}
+
+		draggedFilesCallback = std::move(newValue);
+    }
+	const vector<path>& ProcessWindow::GetLastDraggedFiles() const { return lastDraggedFiles; };
+	void ProcessWindow::ClearLastDraggedFiles() { lastDraggedFiles.clear(); };
+
+    string ProcessWindow::GetTitle() const { return title; }
+    void ProcessWindow::UpdateTitle()
+    {
+        const X11GlobalData& globalData = Window_Global::GetGlobalData();
+        if (!globalData.display)
+        {
+			ForceClose(
+				"update window '" + to_string(ID) + "' title",
+                "the display handle was invalid!");
+        }
+
+        Display* display = ToVar<Display*>(globalData.display);
+        Window window = ToVar<Window>(windowData.window);
+
+        Atom atom_utf8 = ToVar<Atom>(globalData.atom_utf8);
+        Atom atom_net_wm_name = ToVar<Atom>(globalData.atom_net_wm_name);
+
+        Atom actualType{};
+        int actualFormat{};
+        unsigned long nItems{};
+        unsigned long bytesAfter{};
+        unsigned char* prop{};
+
+        XRESULT = XGetWindowProperty(
+            display,
+            window,
+            atom_net_wm_name,
+            0,
+            (~0L),
+            False,
+            atom_utf8,
+            &actualType,
+            &actualFormat,
+            &nItems,
+            &bytesAfter,
+            &prop);
+
+        if (XRESULT != SUCCESS_XGETWINDOWPROPERTY)
+        {
+			ForceClose(
+				"update window '" + to_string(ID) + " title",
+                "XGetWindowProperty failed! Result code: " + to_string(XRESULT));
+        }
+
+        //the property was deleted, keep the last known title
+        if (!prop) return;
+
+        title.assign(rcast<char*>(prop), nItems);
+        XFree(prop);
+    }
+    void ProcessWindow::SetTitle(string&& newValue)
+    {
+        const X11GlobalData& globalData = Window_Global::GetGlobalData();
+        if (!globalData.display)
+        {
+			ForceClose(
+				"set window '" + to_string(ID) + "' title",
+                "the display handle was invalid!");
+        }
+
+		if (newValue.empty()
+            || newValue.length() > MAX_NAME_LENGTH)
+		{
+			Log::Print(
+				"Failed to set window '" + to_string(ID) + "' title "
+                "because the new title is empty or too long!",
+				"KW_WINDOW",
+				LogType::LOG_ERROR,
+				2);
+
+			return;
+		}
+
+        string value(newValue);
+        Display* display = ToVar<Display*>(globalData.display);
+
+        Atom net_wm_name = ToVar<Atom>(globalData.atom_net_wm_name);
+        Atom utf8 = ToVar<Atom>(globalData.atom_utf8);
+
+        XStoreName(
             display, 
             windowData.window, 
             value.c_str());
@@ -535,6 +1241,9 @@ namespace KalaWindow::Graphics
             rcast<const unsigned char*>(value.c_str()),
             value.size());
 
+        //PropertyNotify would bring the same value back, this keeps GetTitle current until then
+        title = value;
+
 		if (Window_Global::IsVerboseLoggingEnabled())
 		{
 			Log::Print(
@@ -555,7 +1264,7 @@ namespace KalaWindow::Graphics
         }
 
         //skip if already focused
-        if (isFocused) return;
+        if (IsFocused()) return;
 
         Display* display = ToVar<Display*>(Window_Global::GetGlobalData().display);
         Window window = ToVar<Window>(windowData.window);
@@ -585,22 +1294,16 @@ namespace KalaWindow::Graphics
                 "XSendEvent failed! Result code: " + to_string(XRESULT));
         }
 
-        XSetICFocus(ToVar<XIC>(windowData.xic));
+        if (windowData.xic) XSetICFocus(ToVar<XIC>(windowData.xic));
         XFlush(display);
     }
 
     vec2 ProcessWindow::GetSize() const { return size; }
     void ProcessWindow::SetSize(vec2 newSize)
     {
-        const X11GlobalData& globalData = Window_Global::GetGlobalData();
-        if (!globalData.display)
-        {
-			ForceClose(
-				"set window '" + to_string(ID) + "' size",
-                "the display handle was invalid!");
-        }
-
-		vec2 oldSize = size;
+		vec2 oldSize = pendingChanges.hasSize
+            ? pendingChanges.size
+            : size;
 		if (isnear(oldSize, newSize))
         {
 			Log::Print(
@@ -633,16 +1336,12 @@ namespace KalaWindow::Graphics
 			return;
 		}
 
-        Display* display = ToVar<Display*>(globalData.display);
-        Window window = ToVar<Window>(windowData.window);
+        PendingWindowChanges& changes = QueueChanges();
+        changes.hasSize = true;
+        changes.size = newSize;
 
-        XResizeWindow(
-            display,
-            window,
-            scast<int>(newSize.x),
-            scast<int>(newSize.y));
-
-        XFlush(display);
+        //a fixed size window keeps its hints pinned to its size
+        if (!isUserResizable) changes.hasSizeHints = true;
 
 		string val = to_string(newSize.x) + "x" + to_string(newSize.y);
 		if (Window_Global::IsVerboseLoggingEnabled())
@@ -657,14 +1356,6 @@ namespace KalaWindow::Graphics
 	vec2 ProcessWindow::GetMaxSize() const { return maxSize; }
     void ProcessWindow::SetMaxSize(vec2 newSize)
     { 
-        const X11GlobalData& globalData = Window_Global::GetGlobalData();
-        if (!globalData.display)
-        {
-			ForceClose(
-				"set window '" + to_string(ID) + "' max size",
-                "the display handle was invalid!");
-        }
-
 		if (isnear(maxSize, newSize))
         {
 			Log::Print(
@@ -699,33 +1390,9 @@ namespace KalaWindow::Graphics
 			return;
 		}
 
-        Display* display = ToVar<Display*>(globalData.display);
-        Window window = ToVar<Window>(windowData.window);
-
-        XSizeHints hints{};
-        long supplied{};
-
-        XGetWMNormalHints(
-            display,
-            window,
-            &hints,
-            &supplied);
-
-        hints.flags |= PMinSize | PMaxSize;
-        hints.min_width = (int)minSize.x;
-        hints.min_height = (int)minSize.y;
-        hints.max_width = (int)maxSize.x;
-        hints.max_height = (int)maxSize.y;
+        maxSize = newSize;
 
-        XSetWMNormalHints(display, window, &hints);
-        XFlush(display);
-
-        XSizeHints verify{};
-        XGetWMNormalHints(
-            display,
-            window,
-            &verify,
-            &supplied);
+        QueueChanges().hasSizeHints = true;
 
 		string val = to_string(newSize.x) + "x" + to_string(newSize.y);
 
@@ -741,14 +1408,6 @@ namespace KalaWindow::Graphics
 	vec2 ProcessWindow::GetMinSize() const { return minSize; }
 	void ProcessWindow::SetMinSize(vec2 newSize)
     { 
-        const X11GlobalData& globalData = Window_Global::GetGlobalData();
-        if (!globalData.display)
-        {
-			ForceClose(
-				"set window '" + to_string(ID) + "' min size",
-                "the display handle was invalid!");
-        }
-
 		if (isnear(minSize, newSize))
         {
 			Log::Print(
@@ -783,33 +1442,9 @@ namespace KalaWindow::Graphics
 			return;
 		}
 
-        Display* display = ToVar<Display*>(globalData.display);
-        Window window = ToVar<Window>(windowData.window);
-
-        XSizeHints hints{};
-        long supplied{};
+        minSize = newSize;
 
-        XGetWMNormalHints(
-            display,
-            window,
-            &hints,
-            &supplied);
-
-        hints.flags |= PMinSize | PMaxSize;
-        hints.min_width = (int)minSize.x;
-        hints.min_height = (int)minSize.y;
-        hints.max_width = (int)maxSize.x;
-        hints.max_height = (int)maxSize.y;
-
-        XSetWMNormalHints(display, window, &hints);
-        XFlush(display);
-
-        XSizeHints verify{};
-        XGetWMNormalHints(
-            display,
-            window,
-            &verify,
-            &supplied);
+        QueueChanges().hasSizeHints = true;
 
 		string val = to_string(newSize.x) + "x" + to_string(newSize.y);
 
@@ -819,144 +1454,33 @@ namespace KalaWindow::Graphics
 				"Set window '" + to_string(ID) + "' min size to '" + val + "'",
 				"KW_WINDOW",
 				LogType::LOG_VERBOSE);
-		}
-    }
-
-    vec2 ProcessWindow::GetPosition() { static vec2 pos{}; return pos; }
-    void ProcessWindow::SetPosition(vec2 newPosition)
-    { 
-        const X11GlobalData& globalData = Window_Global::GetGlobalData();
-        if (!globalData.display)
-        {
-			ForceClose(
-				"set window '" + to_string(ID) + "' pos",
-                "the display handle was invalid!");
-        }
-
-        Display* display = ToVar<Display*>(globalData.display);
-        Window window = ToVar<Window>(windowData.window);
-
-        XMoveWindow(
-            display,
-            window,
-            scast<int>(newPosition.x),
-            scast<int>(newPosition.y));
-
-        XFlush(display);
-
-		string val = to_string(newPosition.x) + "x" + to_string(newPosition.y);
-
-		if (Window_Global::IsVerboseLoggingEnabled())
-		{
-			Log::Print(
-				"Set window '" + to_string(ID) + "' position to '" + val + "'",
-				"KW_WINDOW",
-				LogType::LOG_VERBOSE);
-		}
-    }
-
-    bool ProcessWindow::IsAlwaysOnTop() const
-    {
-        const X11GlobalData& globalData = Window_Global::GetGlobalData();
-        if (!globalData.display)
-        {
-			ForceClose(
-				"get window '" + to_string(ID) + "' always on top state",
-                "the display handle was invalid!");
-        }
-
-        Display* display = ToVar<Display*>(globalData.display);
-        Window window = ToVar<Window>(windowData.window);
-
-        Atom atom_net_wm_state       = ToVar<Atom>(globalData.atom_net_wm_state);
-        Atom atom_net_wm_state_above = ToVar<Atom>(globalData.atom_net_wm_state_above);
-
-        Atom actualType{};
-        int actualFormat{};
-        unsigned long nItems{}, bytesAfter{};
-        unsigned char* data{};
-
-        XRESULT = XGetWindowProperty(
-            display,
-            window,
-            atom_net_wm_state,
-            0,
-            1024,
-            False,
-            XA_ATOM,
-            &actualType,
-            &actualFormat,
-            &nItems,
-            &bytesAfter,
-            &data);
-
-        if (XRESULT != SUCCESS_XGETWINDOWPROPERTY)
-        {
-			ForceClose(
-				"get window '" + to_string(ID) + " always on top state",
-                "XGetWindowProperty failed! Result code: " + to_string(XRESULT));
-        }
-
-        bool isAbove{};
-        if (data)
-        {
-            Atom* atoms = (Atom*)data;
-            for (unsigned long i = 0; i < nItems; i++)
-            {
-                if (atoms[i] == atom_net_wm_state_above)
-                {
-                    isAbove = true;
-                    break;
-                }
-            }
-            XFree(data);
-        }
-
-        return isAbove;
-    }
-    void ProcessWindow::SetAlwaysOnTopState(bool state)
-    { 
-        const X11GlobalData& globalData = Window_Global::GetGlobalData();
-        if (!globalData.display)
-        {
-			ForceClose(
-				"set window '" + to_string(ID) + "' always on top state",
-                "the display handle was invalid!");
-        }
-
-        Display* display = ToVar<Display*>(globalData.display);
-        Window window = ToVar<Window>(windowData.window);
+		}
+    }
 
-        Atom atom_net_wm_state       = ToVar<Atom>(globalData.atom_net_wm_state);
-        Atom atom_net_wm_state_above = ToVar<Atom>(globalData.atom_net_wm_state_above);
-    
-        XEvent event{};
-        event.xclient.type = ClientMessage;
-        event.xclient.window = window;
-        event.xclient.message_type = atom_net_wm_state;
-        event.xclient.format = 32;
-        event.xclient.data.l[0] = state;
-        event.xclient.data.l[1] = atom_net_wm_state_above;
-        event.xclient.data.l[2] = 0;
-        event.xclient.data.l[3] = 0;
-        event.xclient.data.l[4] = 0;
+    vec2 ProcessWindow::GetPosition() { static vec2 pos{}; return pos; }
+    void ProcessWindow::SetPosition(vec2 newPosition)
+    { 
+        PendingWindowChanges& changes = QueueChanges();
+        changes.hasPosition = true;
+        changes.position = newPosition;
 
-        XRESULT = XSendEvent(
-            display,
-            DefaultRootWindow(display),
-            False,
-            SubstructureRedirectMask
-            | SubstructureNotifyMask,
-            &event);
+		string val = to_string(newPosition.x) + "x" + to_string(newPosition.y);
 
-        if (XRESULT != SUCCESS_XSENDEVENT)
-        {
-			ForceClose(
-				"set window '" + to_string(ID) + "' always on top state",
-                "XSendEvent failed! Result code: " + to_string(XRESULT));
-        }
+		if (Window_Global::IsVerboseLoggingEnabled())
+		{
+			Log::Print(
+				"Set window '" + to_string(ID) + "' position to '" + val + "'",
+				"KW_WINDOW",
+				LogType::LOG_VERBOSE);
+		}
+    }
 
-        XFlush(display);
+    bool ProcessWindow::IsAlwaysOnTop() const { return isAlwaysOnTop; }
+    void ProcessWindow::SetAlwaysOnTopState(bool state)
+    { 
+        PendingWindowChanges& changes = QueueChanges();
+        changes.hasAlwaysOnTop = true;
+        changes.isAlwaysOnTop = state;
 
 		string val = state ? "true" : "false";
 
@@ -969,13 +1493,14 @@ namespace KalaWindow::Graphics
 		}
     }
 
-    bool ProcessWindow::IsResizable() const
+    bool ProcessWindow::IsResizable() const { return isResizable; }
+    void ProcessWindow::UpdateResizableState()
     {
         const X11GlobalData& globalData = Window_Global::GetGlobalData();
         if (!globalData.display)
         {
 			ForceClose(
-				"get window '" + to_string(ID) + "' resizable state",
+				"update window '" + to_string(ID) + "' resizable state",
                 "the display handle was invalid!");
         }
 
@@ -1011,65 +1536,28 @@ namespace KalaWindow::Graphics
             if (prop) XFree(prop);
 
             //WM doesnt support EWMH - not resizable as far as we can tell
-            return false;
+            isResizable = false;
+            return;
         }
 
         Atom* allowedActions = rcast<Atom*>(prop);
-        bool resizable{};
+        isResizable = false;
         for (unsigned long i = 0; i < nItems; ++i)
         {
             if (allowedActions[i] == netWmActionResize)
             {
-                resizable = true;
+                isResizable = true;
                 break;
             }
         }
 
         XFree(prop);
-        return resizable;
     }
     void ProcessWindow::SetResizableState(bool state)
     {
-        const X11GlobalData& globalData = Window_Global::GetGlobalData();
-        if (!globalData.display)
-        {
-			ForceClose(
-				"set window '" + to_string(ID) + "' resizable state",
-                "the display handle was invalid!");
-        }
-        
-        Display* display = ToVar<Display*>(globalData.display);
-        Window window = ToVar<Window>(windowData.window);
-
-        XSizeHints hints{};
-        long supplied{};
-
-        XGetWMNormalHints(
-            display,
-            window,
-            &hints,
-            &supplied);
-
-        if (state)
-        {
-            hints.flags |= PMinSize | PMaxSize;
-
-            hints.min_width = 1;
-            hints.min_height = 1;
-
-            hints.max_width = scast<int>(maxSize.x);
-            hints.max_height = scast<int>(maxSize.y);
-        }
-        else
-        {
-            hints.flags |= PMinSize | PMaxSize;
+        isUserResizable = state;
 
-            hints.min_width = hints.max_width = scast<int>(size.x);
-            hints.min_height = hints.max_height = scast<int>(size.y);
-        }
-
-        XSetWMNormalHints(display, window, &hints);
-        XFlush(display);
+        QueueChanges().hasSizeHints = true;
 
 		string val = state ? "true" : "false";
 
@@ -1082,13 +1570,14 @@ namespace KalaWindow::Graphics
 		}
     }
 
-    pair<string, string> ProcessWindow::GetWindowClass() const
+    pair<string, string> ProcessWindow::GetWindowClass() const { return windowClass; }
+    void ProcessWindow::UpdateWindowClass()
     {
         const X11GlobalData& globalData = Window_Global::GetGlobalData();
         if (!globalData.display)
         {
 			ForceClose(
-				"get window '" + to_string(ID) + "' class",
+				"update window '" + to_string(ID) + "' class",
                 "the display handle was invalid!");
         }
 
@@ -1101,17 +1590,20 @@ namespace KalaWindow::Graphics
         if (!classHint.res_name
             || !classHint.res_class)
         {
+            if (classHint.res_name) XFree(classHint.res_name);
+            if (classHint.res_class) XFree(classHint.res_class);
+
 			Log::Print(
-				"Failed to get window '" + to_string(ID) + "' class value "
-                "because XClassHint failed or it had no name or class value! Result code: " + to_string(XRESULT),
+				"Failed to update window '" + to_string(ID) + "' class value "
+                "because XClassHint failed or it had no name or class value!",
 				"KW_WINDOW",
 				LogType::LOG_ERROR,
 				2);
 
-            return { "", "" };
+            return;
         }
 
-        pair<string, string> result
+        windowClass =
         { 
             classHint.res_name,
             classHint.res_class
@@ -1119,8 +1611,6 @@ namespace KalaWindow::Graphics
 
         XFree(classHint.res_name);
         XFree(classHint.res_class);
-
-        return result;
     }
     void ProcessWindow::SetWindowClass(string&& newValue)
     {
@@ -1156,6 +1646,9 @@ namespace KalaWindow::Graphics
             windowData.window,
             &classHint);
 
+        //PropertyNotify would bring the same value back, this keeps GetWindowClass current until then
+        windowClass = { nameClassValue, nameClassValue };
+
 		if (Window_Global::IsVerboseLoggingEnabled())
 		{
 			Log::Print(
@@ -1165,226 +1658,618 @@ namespace KalaWindow::Graphics
 		}
     }
 
-    bool ProcessWindow::IsIdle() const { return isIdle; }
+    bool ProcessWindow::IsIdle() const
+    {
+        const WindowHotState* hot = GetHotState();
+        return hot && hot->isIdle;
+    }
 
-    bool ProcessWindow::IsHovered() const { return isWindowHovered; }
-    bool ProcessWindow::IsForegroundWindow() const { return isFocused; }
-    bool ProcessWindow::IsFocused() const { return isFocused; }
+    bool ProcessWindow::IsHovered() const
+    {
+        const WindowHotState* hot = GetHotState();
+        return hot && hot->isHovered;
+    }
+    bool ProcessWindow::IsForegroundWindow() const { return IsFocused(); }
+    bool ProcessWindow::IsFocused() const
+    {
+        const WindowHotState* hot = GetHotState();
+        return hot && hot->isFocused;
+    }
     bool ProcessWindow::IsFullscreen() { return isFullscreen; }
-    bool ProcessWindow::IsMinimized() const { return isMinimized; }
-    bool ProcessWindow::IsVisible() const { return isVisible; }
-	bool ProcessWindow::IsResizing() const { return isResizing; }
+    bool ProcessWindow::IsMinimized() const
+    {
+        const WindowHotState* hot = GetHotState();
+        return hot && hot->isMinimized;
+    }
+    bool ProcessWindow::IsVisible() const
+    {
+        const WindowHotState* hot = GetHotState();
+        return hot && hot->isVisible;
+    }
+	bool ProcessWindow::IsResizing() const
+	{
+		const WindowHotState* hot = GetHotState();
+		return hot && hot->isResizing;
+	}
 
     WindowMode ProcessWindow::GetWindowMode() { return windowMode; }
     void ProcessWindow::SetWindowMode(WindowMode mode)
     {
-        const X11GlobalData& globalData = Window_Global::GetGlobalData();
-        if (!globalData.display)
+        string windowModeVal{};
+
+        switch (mode)
         {
-			ForceClose(
-				"set window '" + to_string(ID) + "' mode",
-                "the display handle was invalid!");
+        case WindowMode::WINDOWMODE_WINDOWED:
+            windowModeVal = "windowed";
+            break;
+        case WindowMode::WINDOWMODE_BORDERLESS:
+            windowModeVal = "borderless";
+            break;
+        case WindowMode::WINDOWMODE_EXCLUSIVE:
+            windowModeVal = "exclusive";
+            break;
+        default: break;
+        }
+
+        PendingWindowChanges& changes = QueueChanges();
+        changes.hasWindowMode = true;
+        changes.windowMode = mode;
+
+        //restore the pre-fullscreen rect
+        changes.hasPosition = true;
+        changes.position = oldPos;
+        changes.hasSize = true;
+        changes.size = oldSize;
+
+        windowMode = mode;
+
+        //the window goes fullscreen like borderless, only the monitor mode differs. The mode is
+        //switched from UpdateFullscreenAndMinimizedState once the WM confirms fullscreen
+        if (mode != WindowMode::WINDOWMODE_EXCLUSIVE) RestoreExclusiveDisplayMode();
+
+		if (Window_Global::IsVerboseLoggingEnabled())
+		{
+			Log::Print(
+				"Set window '" + to_string(ID) + "' mode to '" + windowModeVal + "'",
+				"KW_WINDOW",
+				LogType::LOG_VERBOSE);
+		}
+    }
+
+    void ProcessWindow::SetExclusiveDisplayMode(
+        vec2 size,
+        f32 refreshRate)
+    {
+        exclusiveSize = size;
+        exclusiveRefreshRate = refreshRate;
+
+        ApplyExclusiveDisplayMode();
+    }
+
+    void ProcessWindow::ApplyExclusiveDisplayMode()
+    {
+        //an unfocused or not yet fullscreen window must never change a monitor,
+        //focus in and the fullscreen state change both call this again
+        if (windowMode != WindowMode::WINDOWMODE_EXCLUSIVE
+            || !isFullscreen
+            || !IsFocused())
+        {
+            return;
+        }
+
+        //without a requested mode exclusive stays identical to borderless
+        if (exclusiveSize.x <= 0.0f
+            && exclusiveSize.y <= 0.0f
+            && exclusiveRefreshRate <= 0.0f)
+        {
+            return;
+        }
+
+        const MonitorData* monitor = GetMonitor();
+        if (!monitor
+            || monitor->crtc == 0)
+        {
+            Log::Print(
+                "Failed to apply exclusive display mode for window '" + to_string(ID) + "' because it is not on an XRandR monitor!",
+                "KW_WINDOW",
+                LogType::LOG_ERROR,
+                2);
+
+            return;
+        }
+
+        //the window was moved to another monitor, give the old one back first
+        if (exclusiveCrtc != 0
+            && exclusiveCrtc != monitor->crtc)
+        {
+            RestoreExclusiveDisplayMode();
+        }
+
+        uintptr_t crtc = monitor->crtc;
+        u32 width = exclusiveSize.x > 0.0f
+            ? scast<u32>(exclusiveSize.x)
+            : monitor->width;
+        u32 height = exclusiveSize.y > 0.0f
+            ? scast<u32>(exclusiveSize.y)
+            : monitor->height;
+
+        if (Window_Global::SetCrtcMode(
+            crtc,
+            width,
+            height,
+            exclusiveRefreshRate))
+        {
+            exclusiveCrtc = crtc;
+        }
+    }
+
+    void ProcessWindow::RestoreExclusiveDisplayMode()
+    {
+        if (exclusiveCrtc == 0) return;
+
+        Window_Global::RestoreCrtcMode(exclusiveCrtc);
+        exclusiveCrtc = 0;
+    }
+
+    CompositorBypass ProcessWindow::GetCompositorBypass() const { return compositorBypass; }
+    void ProcessWindow::SetCompositorBypass(CompositorBypass newValue)
+    {
+        compositorBypass = newValue;
+
+        UpdateCompositorBypass();
+    }
+
+    bool ProcessWindow::IsCompositorBypassRequested() const { return compositorBypassValue == 1; }
+
+    void ProcessWindow::UpdateCompositorBypass()
+    {
+        //0 = no preference, 1 = unredirect, 2 = keep composited
+        u32 newValue{};
+
+        switch (compositorBypass)
+        {
+        case CompositorBypass::COMPOSITOR_BYPASS_OFF:
+            newValue = 2;
+            break;
+        case CompositorBypass::COMPOSITOR_BYPASS_FULLSCREEN:
+            newValue = isFullscreen ? 1 : 0;
+            break;
+        case CompositorBypass::COMPOSITOR_BYPASS_ALWAYS:
+            newValue = 1;
+            break;
+        default: break;
         }
 
+        if (newValue == compositorBypassValue) return;
+
+        const X11GlobalData& globalData = Window_Global::GetGlobalData();
+
         Display* display = ToVar<Display*>(globalData.display);
         Window window = ToVar<Window>(windowData.window);
+        Atom netWmBypassCompositor = ToVar<Atom>(globalData.atom_net_wm_bypass_compositor);
+
+        //only buffered, Update flushes it with the rest of the frame's requests
+        if (newValue == 0) XDeleteProperty(display, window, netWmBypassCompositor);
+        else
+        {
+            unsigned long value = newValue;
+
+            XChangeProperty(
+                display,
+                window,
+                netWmBypassCompositor,
+                XA_CARDINAL,
+                32,
+                PropModeReplace,
+                rcast<unsigned char*>(&value),
+                1);
+        }
+
+        compositorBypassValue = newValue;
+
+		if (Window_Global::IsVerboseLoggingEnabled())
+		{
+			Log::Print(
+				"Set window '" + to_string(ID) + "' compositor bypass to '" + to_string(newValue) + "'",
+				"KW_WINDOW",
+				LogType::LOG_VERBOSE);
+		}
+    }
+
+    void ProcessWindow::SetOpaqueRegion(vector<WindowRect>&& rects)
+    {
+        opaqueRects = std::move(rects);
+        isOpaqueRegionCustom = true;
+
+        UpdateOpaqueRegion();
+    }
+    void ProcessWindow::ResetOpaqueRegion()
+    {
+        opaqueRects.clear();
+        isOpaqueRegionCustom = false;
+        opaqueRegionSize = {};
+
+        UpdateOpaqueRegion();
+    }
+    bool ProcessWindow::HasCustomOpaqueRegion() const { return isOpaqueRegionCustom; }
+
+    bool ProcessWindow::IsVariableRefreshEnabled() const { return isVariableRefreshEnabled; }
+    void ProcessWindow::SetVariableRefreshState(bool state)
+    {
+        isVariableRefreshEnabled = state;
+
+        UpdateVariableRefresh();
+    }
+    bool ProcessWindow::IsVariableRefreshActive() const { return isVariableRefreshActive; }
+
+    bool ProcessWindow::IsWaitingForCompositor() const
+    {
+        return isWaitingForCompositor
+            && KalaWindowCore::GetMonotonicTime() - compositorWaitStart < COMPOSITOR_WAIT_TIMEOUT;
+    }
+    const CompositorFrameTiming& ProcessWindow::GetLastCompositorFrameTiming() const { return lastCompositorFrameTiming; }
+
+    bool ProcessWindow::IsPresentTimingAvailable() const { return presentEventID != 0; }
+    const PresentTiming& ProcessWindow::GetLastPresentTiming() const { return lastPresentTiming; }
+
+    u64 ProcessWindow::GetNextVblankTime() const
+    {
+        u64 lastTime = lastPresentTiming.presentTime;
+        u64 interval = lastPresentTiming.refreshInterval;
+
+        if (lastTime == 0
+            || interval == 0)
+        {
+            return 0;
+        }
+
+        u64 now = KalaWindowCore::GetMonotonicTime();
+        if (now < lastTime) return lastTime;
+
+        return lastTime + ((now - lastTime) / interval + 1) * interval;
+    }
+
+    void ProcessWindow::RequestVblankTiming()
+    {
+        if (!presentEventID) return;
+
+        Display* display = ToVar<Display*>(Window_Global::GetGlobalData().display);
+        Window window = ToVar<Window>(windowData.window);
+
+        //divisor 1 and remainder 0 match the first vblank after the current one
+        XPresentNotifyMSC(
+            display,
+            window,
+            0,
+            0,
+            1,
+            0);
+
+        //the answer is only useful if the request leaves before that vblank
+        XFlush(display);
+    }
+
+    void ProcessWindow::HandlePresentComplete(
+        u32 serial,
+        u64 ust,
+        u64 msc,
+        u8 mode)
+    {
+        //ust is CLOCK_MONOTONIC microseconds, the same clock GetMonotonicTime reads
+        u64 presentTime = ust * 1000;
+
+        u64 refreshInterval = lastPresentTiming.refreshInterval;
+
+        //skipped and missed vblanks still advance the counter, so any two timings give the interval
+        if (lastPresentTiming.msc != 0
+            && msc > lastPresentTiming.msc
+            && presentTime > lastPresentTiming.presentTime)
+        {
+            refreshInterval = (presentTime - lastPresentTiming.presentTime) / (msc - lastPresentTiming.msc);
+        }
+        else if (refreshInterval == 0)
+        {
+            const MonitorData* monitor = GetMonitor();
+            if (monitor
+                && monitor->refreshRate > 0.0f)
+            {
+                refreshInterval = scast<u64>(1000000000.0 / monitor->refreshRate);
+            }
+        }
+
+        lastPresentTiming =
+        {
+            .serial = serial,
+            .msc = msc,
+            .presentTime = presentTime,
+            .refreshInterval = refreshInterval,
+            .isFlip = mode == PresentCompleteModeFlip,
+            .isSkipped = mode == PresentCompleteModeSkip
+        };
+
+        if (Window_Global::IsVerboseLoggingEnabled())
+        {
+			Log::Print(
+				"Window '" + to_string(ID) + "' presented serial '" + to_string(serial)
+				+ "' at msc '" + to_string(msc) + "' with a refresh interval of '" + to_string(refreshInterval) + "' ns.",
+				"KW_WINDOW",
+				LogType::LOG_VERBOSE);
+        }
+    }
+
+    void ProcessWindow::BeginSyncFrame(u64 frameID)
+    {
+        //frames in flight finish in order, the next one is tracked once the current one is done
+        if (!extendedSyncCounter
+            || syncFrameID != 0)
+        {
+            return;
+        }
+
+        syncFrameID = frameID;
+        syncFrameStart = KalaWindowCore::GetMonotonicTime();
+        hasSyncFrames = true;
+
+        //this frame is the first one drawn at the size from the last sync request
+        isSyncFrameResize = isSyncConfigurePending;
+        isSyncConfigurePending = false;
+
+        //an odd value tells the compositor a frame is being drawn
+        if (extendedSyncValue % 2 == 0) ++extendedSyncValue;
+
+        XSyncValue value{};
+        XSyncIntsToValue(
+            &value,
+            scast<unsigned int>(extendedSyncValue & 0xFFFFFFFF),
+            scast<int>(extendedSyncValue >> 32));
+
+        Display* display = ToVar<Display*>(Window_Global::GetGlobalData().display);
+
+        XSyncSetCounter(
+            display,
+            ToVar<XSyncCounter>(extendedSyncCounter),
+            value);
+    }
+
+    void ProcessWindow::FinishSyncFrame()
+    {
+        Display* display = ToVar<Display*>(Window_Global::GetGlobalData().display);
+
+        //next even value, and never below what the WM asked for
+        extendedSyncValue = (extendedSyncValue | 1) + 1;
+        if (isSyncFrameResize
+            && syncRequestValue > extendedSyncValue)
+        {
+            extendedSyncValue = syncRequestValue + (syncRequestValue % 2);
+        }
+
+        XSyncValue value{};
+        XSyncIntsToValue(
+            &value,
+            scast<unsigned int>(extendedSyncValue & 0xFFFFFFFF),
+            scast<int>(extendedSyncValue >> 32));
+
+        XSyncSetCounter(
+            display,
+            ToVar<XSyncCounter>(extendedSyncCounter),
+            value);
+
+        //the basic counter only answers sync requests, the WM waits on it before the next resize step
+        if (isSyncFrameResize)
+        {
+            XSyncIntsToValue(
+                &value,
+                scast<unsigned int>(syncRequestValue & 0xFFFFFFFF),
+                scast<int>(syncRequestValue >> 32));
+
+            XSyncSetCounter(
+                display,
+                ToVar<XSyncCounter>(syncCounter),
+                value);
+        }
+
+        syncFrameID = 0;
+        isSyncFrameResize = false;
+
+        //only a compositor that already reported a frame will report this one too
+        if (hasCompositorFrameDrawn)
+        {
+            isWaitingForCompositor = true;
+            compositorWaitStart = KalaWindowCore::GetMonotonicTime();
+        }
+    }
 
-        Atom atom_net_wm_state            = ToVar<Atom>(globalData.atom_net_wm_state);
-        Atom atom_net_wm_state_fullscreen = ToVar<Atom>(globalData.atom_net_wm_state_fullscreen);
+    void ProcessWindow::SendAllSyncCounters()
+    {
+        if (!Window_Global::GetGlobalData().hasSync) return;
 
-        long action{};
+        for (ProcessWindow* pw : registry.GetAllContent())
+        {
+            if (!pw
+                || !pw->syncCounter)
+            {
+                continue;
+            }
 
-        string windowModeVal{};
+            //without latency markers the configure counts as handled once Update is done,
+            //otherwise the WM would keep waiting on a frame that is never reported
+            if (!pw->hasSyncFrames)
+            {
+                if (pw->isSyncConfigurePending)
+                {
+                    pw->isSyncConfigurePending = false;
+                    pw->isSyncFrameResize = true;
+                    pw->FinishSyncFrame();
+                }
 
-        switch (mode)
-        {
-        case WindowMode::WINDOWMODE_WINDOWED:
-            windowModeVal = "windowed";
+                continue;
+            }
 
-            action = 0;
-            break;
-        case WindowMode::WINDOWMODE_BORDERLESS:
-        case WindowMode::WINDOWMODE_EXCLUSIVE:
-            windowModeVal = "borderless";
+            if (pw->syncFrameID == 0) continue;
 
-            action = 1;
-            SetPosition(oldPos);
-            SetSize(oldSize);
-            break;
-        default: break;
+            //a destroyed context, a frame whose in-flight slot was reused without a present
+            //and a frame that never got presented in time all finish the sync frame as well
+            VulkanContext* context = VulkanContext::GetRegistry().GetContent(pw->graphicsContextID);
+            bool isFrameDone = !context
+                || context->GetLastPresentedFrameID() >= pw->syncFrameID
+                || context->lastFrameID >= pw->syncFrameID + MAX_FRAMES_IN_FLIGHT
+                || KalaWindowCore::GetMonotonicTime() - pw->syncFrameStart >= SYNC_FRAME_TIMEOUT;
+
+            if (isFrameDone) pw->FinishSyncFrame();
         }
+    }
 
-        XEvent event{};
-        event.xclient.type = ClientMessage;
-        event.xclient.window = window;
-        event.xclient.message_type = atom_net_wm_state;
-        event.xclient.format = 32;
-        event.xclient.data.l[0] = action;
-        event.xclient.data.l[1] = atom_net_wm_state_fullscreen;
-        event.xclient.data.l[2] = 0;
-        event.xclient.data.l[3] = 0;
-        event.xclient.data.l[4] = 0;
+    void ProcessWindow::UpdateVariableRefresh()
+    {
+        //drivers only flip fullscreen windows, so the hint is kept off everywhere else
+        bool newState = isVariableRefreshEnabled && isFullscreen;
+        if (newState == isVariableRefreshActive) return;
 
-        XRESULT = XSendEvent(
-            display,
-            DefaultRootWindow(display),
-            False,
-            SubstructureRedirectMask
-            | SubstructureNotifyMask,
-            &event);
+        const X11GlobalData& globalData = Window_Global::GetGlobalData();
 
-        if (XRESULT != SUCCESS_XSENDEVENT)
-        {
-			ForceClose(
-				"set window '" + to_string(ID) + "' mode",
-                "XSendEvent failed! Result code: " + to_string(XRESULT));
-        }
+        Display* display = ToVar<Display*>(globalData.display);
+        Window window = ToVar<Window>(windowData.window);
+        Atom variableRefresh = ToVar<Atom>(globalData.atom_variable_refresh);
 
-        if (mode == WindowMode::WINDOWMODE_WINDOWED)
+        //only buffered, Update flushes it with the rest of the frame's requests
+        if (newState)
         {
-            SetPosition(oldPos);
-            SetSize(oldSize);
-        }
+            unsigned long value = 1;
 
-        XFlush(display);
+            XChangeProperty(
+                display,
+                window,
+                variableRefresh,
+                XA_CARDINAL,
+                32,
+                PropModeReplace,
+                rcast<unsigned char*>(&value),
+                1);
+        }
+        else XDeleteProperty(display, window, variableRefresh);
 
-        windowMode = mode;
+        isVariableRefreshActive = newState;
 
 		if (Window_Global::IsVerboseLoggingEnabled())
 		{
 			Log::Print(
-				"Set window '" + to_string(ID) + "' mode to '" + windowModeVal + "'",
+				"Set window '" + to_string(ID) + "' variable refresh to '" + (newState ? "on" : "off") + "'",
 				"KW_WINDOW",
 				LogType::LOG_VERBOSE);
 		}
     }
 
-    WindowState ProcessWindow::GetWindowState() const { return windowState; }
-    void ProcessWindow::SetWindowState(WindowState state)
+    void ProcessWindow::UpdateOpaqueRegion(bool isConfigure)
     {
-        const X11GlobalData& globalData = Window_Global::GetGlobalData();
-        if (!globalData.display)
+        //SetOpaqueRegion already wrote the custom region, moves and resizes never change it
+        if (isOpaqueRegionCustom
+            && isConfigure)
         {
-			ForceClose(
-				"set window '" + to_string(ID) + "' state",
-                "the display handle was invalid!");
+            return;
+        }
+
+        if (!isOpaqueRegionCustom)
+        {
+            //moves also send ConfigureNotify, only a new size needs a new region
+            if (opaqueRegionSize.x == size.x
+                && opaqueRegionSize.y == size.y)
+            {
+                return;
+            }
+
+            opaqueRegionSize = size;
         }
 
+        const X11GlobalData& globalData = Window_Global::GetGlobalData();
+
         Display* display = ToVar<Display*>(globalData.display);
         Window window = ToVar<Window>(windowData.window);
+        Atom netWmOpaqueRegion = ToVar<Atom>(globalData.atom_net_wm_opaque_region);
 
-        string windowStateVal{};
-
-        switch (state)
-        {
-        case WindowState::WINDOW_NORMAL:
-        case WindowState::WINDOW_SHOWNOACTIVATE:
+        //only buffered, Update flushes it with the rest of the frame's requests
+        if (isOpaqueRegionCustom)
         {
-            windowStateVal = "normal";
+            if (opaqueRects.empty())
+            {
+                XDeleteProperty(display, window, netWmOpaqueRegion);
+                return;
+            }
 
-            Atom atom_net_wm_state            = ToVar<Atom>(globalData.atom_net_wm_state);
-            Atom atom_net_wm_state_fullscreen = ToVar<Atom>(globalData.atom_net_wm_state_fullscreen);
-            Atom atom_net_wm_state_horizontal = ToVar<Atom>(globalData.atom_net_wm_state_horizontal);
-            Atom atom_net_wm_state_vertical   = ToVar<Atom>(globalData.atom_net_wm_state_vertical);
-            
-            XEvent event{};
-            event.xclient.type = ClientMessage;
-            event.xclient.window = window;
-            event.xclient.message_type = atom_net_wm_state;
-            event.xclient.format = 32;
-            event.xclient.data.l[0] = 0; //remove hints
-            event.xclient.data.l[1] = atom_net_wm_state_vertical;
-            event.xclient.data.l[2] = atom_net_wm_state_horizontal;
-            event.xclient.data.l[3] = atom_net_wm_state_fullscreen;
-            event.xclient.data.l[4] = 0;
-
-            XRESULT = XSendEvent(
-                display,
-                DefaultRootWindow(display),
-                False,
-                SubstructureRedirectMask
-                | SubstructureNotifyMask,
-                &event);
+            vector<unsigned long> values{};
+            values.reserve(opaqueRects.size() * 4);
 
-            if (XRESULT != SUCCESS_XSENDEVENT)
+            for (const WindowRect& rect : opaqueRects)
             {
-                ForceClose(
-                    "set window '" + to_string(ID) + "' state",
-                    "XSendEvent failed! Result code: " + to_string(XRESULT));
+                values.push_back(scast<unsigned long>(rect.x));
+                values.push_back(scast<unsigned long>(rect.y));
+                values.push_back(rect.width);
+                values.push_back(rect.height);
             }
 
-            XMapWindow(display, window);
-
-            SetPosition(oldPos);
-            SetSize(oldSize);
+            XChangeProperty(
+                display,
+                window,
+                netWmOpaqueRegion,
+                XA_CARDINAL,
+                32,
+                PropModeReplace,
+                rcast<unsigned char*>(values.data()),
+                scast<int>(values.size()));
 
-            break;
+            return;
         }
-        case WindowState::WINDOW_MAXIMIZE:
+
+        unsigned long values[4] =
         {
-            windowStateVal = "maximize";
+            0,
+            0,
+            scast<unsigned long>(size.x),
+            scast<unsigned long>(size.y)
+        };
 
-            SetPosition(oldPos);
-            SetSize(oldSize);
-
-            Atom atom_net_wm_state            = ToVar<Atom>(globalData.atom_net_wm_state);
-            Atom atom_net_wm_state_horizontal = ToVar<Atom>(globalData.atom_net_wm_state_horizontal);
-            Atom atom_net_wm_state_vertical   = ToVar<Atom>(globalData.atom_net_wm_state_vertical);
-            
-            XEvent event{};
-            event.xclient.type = ClientMessage;
-            event.xclient.window = window;
-            event.xclient.message_type = atom_net_wm_state;
-            event.xclient.format = 32;
-            event.xclient.data.l[0] = 1; //add hints
-            event.xclient.data.l[1] = atom_net_wm_state_vertical;
-            event.xclient.data.l[2] = atom_net_wm_state_horizontal;
-            event.xclient.data.l[3] = 0;
-            event.xclient.data.l[4] = 0;
-
-            XRESULT = XSendEvent(
-                display,
-                DefaultRootWindow(display),
-                False,
-                SubstructureRedirectMask
-                | SubstructureNotifyMask,
-                &event);
+        XChangeProperty(
+            display,
+            window,
+            netWmOpaqueRegion,
+            XA_CARDINAL,
+            32,
+            PropModeReplace,
+            rcast<unsigned char*>(values),
+            4);
+    }
 
-            if (XRESULT != SUCCESS_XSENDEVENT)
-            {
-                ForceClose(
-                    "set window '" + to_string(ID) + "' state",
-                    "XSendEvent failed! Result code: " + to_string(XRESULT));
-            }
+    WindowState ProcessWindow::GetWindowState() const { return windowState; }
+    void ProcessWindow::SetWindowState(WindowState state)
+    {
+        string windowStateVal{};
 
-            XMapWindow(display, window);
+        switch (state)
+        {
+        case WindowState::WINDOW_NORMAL:
+        case WindowState::WINDOW_SHOWNOACTIVATE:
+            windowStateVal = "normal";
+            break;
+        case WindowState::WINDOW_MAXIMIZE:
+            windowStateVal = "maximize";
             break;
-        }
         case WindowState::WINDOW_MINIMIZE:
-        {
             windowStateVal = "minimize";
-
-            SetPosition(oldPos);
-            SetSize(oldSize);
-
-            int screen = DefaultScreen(display);
-            XIconifyWindow(display, window, screen);
             break;
-        }
         case WindowState::WINDOW_HIDE:
-        {
             windowStateVal = "hide";
-
-            SetPosition(oldPos);
-            SetSize(oldSize);
-
-            XUnmapWindow(display, window);
             break;
-        }
         default: break;
         }
 
-        XFlush(display);
+        PendingWindowChanges& changes = QueueChanges();
+        changes.hasWindowState = true;
+        changes.windowState = state;
+
+        //restore the pre-fullscreen rect
+        changes.hasPosition = true;
+        changes.position = oldPos;
+        changes.hasSize = true;
+        changes.size = oldSize;
 
         windowState = state;
 
@@ -1410,6 +2295,8 @@ namespace KalaWindow::Graphics
 		}
 
 		earlyUpdateCallback = std::move(newValue);
+
+		if (WindowHotState* hot = GetHotState()) hot->hasEarlyUpdateCallback = scast<bool>(earlyUpdateCallback);
     }
     void ProcessWindow::SetUpdateCallback(function<void()>&& newValue)
     {
@@ -1422,6 +2309,8 @@ namespace KalaWindow::Graphics
 		}
 
 		updateCallback = std::move(newValue);
+
+		if (WindowHotState* hot = GetHotState()) hot->hasUpdateCallback = scast<bool>(updateCallback);
     }
     void ProcessWindow::SetLateUpdateCallback(function<void()>&& newValue)
     {
@@ -1434,6 +2323,8 @@ namespace KalaWindow::Graphics
 		}
 
 		lateUpdateCallback = std::move(newValue);
+
+		if (WindowHotState* hot = GetHotState()) hot->hasLateUpdateCallback = scast<bool>(lateUpdateCallback);
     }
 
 	void ProcessWindow::SetResizeCallback(function<void()>&& newValue)
@@ -1449,6 +2340,19 @@ namespace KalaWindow::Graphics
 		resizeCallback = std::move(newValue);
 	}
 
+	void ProcessWindow::SetErrorCallback(function<void(const X11Error&)>&& newValue)
+	{
+		if (!newValue)
+		{
+			Log::Print(
+				"Assigned empty error callback to window '" + to_string(ID) + "'.",
+				"KW_WINDOW",
+				LogType::LOG_WARNING);
+		}
+
+		errorCallback = std::move(newValue);
+	}
+
 	void ProcessWindow::SetShutdownCallback(function<void()>&& newValue)
 	{
 		if (!newValue)
@@ -1464,10 +2368,19 @@ namespace KalaWindow::Graphics
 
     void ProcessWindow::UpdateIdleState()
     {
-        isIdle =
-            !IsForegroundWindow()
-            || IsMinimized()
-            || !IsVisible();
+        WindowHotState* hot = GetHotState();
+        if (!hot) return;
+
+        hot->isIdle =
+            (!hot->isFocused
+            && !hot->isPopup)
+            || hot->isMinimized
+            || !hot->isVisible;
+    }
+
+    WindowHotState* ProcessWindow::GetHotState() const
+    {
+        return KalaWindowRegistry<ProcessWindow>::GetHotContent(ID);
     }
     
     void ProcessWindow::UpdateFullscreenAndMinimizedState()
@@ -1492,6 +2405,7 @@ namespace KalaWindow::Graphics
         Atom netWmState = ToVar<Atom>(globalData.atom_net_wm_state);
         Atom netWmStateFullscreen = ToVar<Atom>(globalData.atom_net_wm_state_fullscreen);
         Atom netWmStateHidden = ToVar<Atom>(globalData.atom_net_wm_state_hidden);
+        Atom netWmStateAbove = ToVar<Atom>(globalData.atom_net_wm_state_above);
 
         XRESULT = XGetWindowProperty(
             display,
@@ -1514,10 +2428,14 @@ namespace KalaWindow::Graphics
                 "XGetWindowProperty failed! Result code: " + to_string(XRESULT));
         }
 
-        bool wasMinimized = isMinimized;
+        WindowHotState* hot = GetHotState();
+        if (!hot) return;
+
+        bool wasMinimized = hot->isMinimized;
+        bool isMinimized = false;
 
         isFullscreen = false;
-        isMinimized = false;
+        isAlwaysOnTop = false;
 
         if (data)
         {
@@ -1527,17 +2445,21 @@ namespace KalaWindow::Graphics
             {
                 if (atoms[i] == netWmStateFullscreen) isFullscreen = true;
                 if (atoms[i] == netWmStateHidden) isMinimized = true;
-
-                if (isFullscreen
-                    && isMinimized)
-                {
-                    break;
-                }
+                if (atoms[i] == netWmStateAbove) isAlwaysOnTop = true;
             }
 
             XFree(data);
         }
 
+        hot->isMinimized = isMinimized;
+
+        UpdateCompositorBypass();
+        UpdateVariableRefresh();
+
+        //the monitor mode only changes once the WM confirmed fullscreen, and goes back when it drops it
+        if (isFullscreen) ApplyExclusiveDisplayMode();
+        else RestoreExclusiveDisplayMode();
+
         if (!wasMinimized
             && isMinimized)
         {
@@ -1568,8 +2490,282 @@ namespace KalaWindow::Graphics
         }
     }
 
+    PendingWindowChanges& ProcessWindow::QueueChanges()
+    {
+        if (!pendingChanges.isQueued)
+        {
+            pendingChanges.isQueued = true;
+            changedWindowIDs.push_back(ID);
+        }
+
+        return pendingChanges;
+    }
+
+    void ProcessWindow::SendPendingChanges()
+    {
+        const X11GlobalData& globalData = Window_Global::GetGlobalData();
+        if (!globalData.display)
+        {
+			ForceClose(
+				"send window '" + to_string(ID) + "' changes",
+                "the display handle was invalid!");
+        }
+
+        PendingWindowChanges changes = pendingChanges;
+        pendingChanges = {};
+
+        Display* display = ToVar<Display*>(globalData.display);
+        Window window = ToVar<Window>(windowData.window);
+
+        Atom atom_net_wm_state = ToVar<Atom>(globalData.atom_net_wm_state);
+
+        auto sendStateMessage = [&](
+            long action,
+            Atom first,
+            Atom second,
+            Atom third)
+            {
+                XEvent event{};
+                event.xclient.type = ClientMessage;
+                event.xclient.window = window;
+                event.xclient.message_type = atom_net_wm_state;
+                event.xclient.format = 32;
+                event.xclient.data.l[0] = action;
+                event.xclient.data.l[1] = first;
+                event.xclient.data.l[2] = second;
+                event.xclient.data.l[3] = third;
+                event.xclient.data.l[4] = 0;
+
+                XRESULT = XSendEvent(
+                    display,
+                    DefaultRootWindow(display),
+                    False,
+                    SubstructureRedirectMask
+                    | SubstructureNotifyMask,
+                    &event);
+
+                if (XRESULT != SUCCESS_XSENDEVENT)
+                {
+                    ForceClose(
+                        "send window '" + to_string(ID) + "' changes",
+                        "XSendEvent failed! Result code: " + to_string(XRESULT));
+                }
+            };
+
+        Atom atom_net_wm_state_fullscreen = ToVar<Atom>(globalData.atom_net_wm_state_fullscreen);
+        Atom atom_net_wm_state_horizontal = ToVar<Atom>(globalData.atom_net_wm_state_horizontal);
+        Atom atom_net_wm_state_vertical   = ToVar<Atom>(globalData.atom_net_wm_state_vertical);
+
+        auto sendModeAndState = [&]()
+            {
+                if (changes.hasWindowMode)
+                {
+                    long action = changes.windowMode == WindowMode::WINDOWMODE_WINDOWED ? 0 : 1;
+                    sendStateMessage(action, atom_net_wm_state_fullscreen, 0, 0);
+                }
+
+                if (!changes.hasWindowState) return;
+
+                switch (changes.windowState)
+                {
+                case WindowState::WINDOW_NORMAL:
+                case WindowState::WINDOW_SHOWNOACTIVATE:
+                    //remove hints
+                    sendStateMessage(
+                        0,
+                        atom_net_wm_state_vertical,
+                        atom_net_wm_state_horizontal,
+                        atom_net_wm_state_fullscreen);
+                    XMapWindow(display, window);
+                    break;
+                case WindowState::WINDOW_MAXIMIZE:
+                    //add hints
+                    sendStateMessage(
+                        1,
+                        atom_net_wm_state_vertical,
+                        atom_net_wm_state_horizontal,
+                        0);
+                    XMapWindow(display, window);
+                    break;
+                case WindowState::WINDOW_MINIMIZE:
+                    XIconifyWindow(display, window, DefaultScreen(display));
+                    break;
+                case WindowState::WINDOW_HIDE:
+                    XUnmapWindow(display, window);
+                    break;
+                default: break;
+                }
+            };
+
+        //hints go first so the WM already accepts the new size
+        if (changes.hasSizeHints)
+        {
+            vec2 fixedSize = changes.hasSize
+                ? changes.size
+                : size;
+
+            XSizeHints hints{};
+            hints.flags = PMinSize | PMaxSize;
+
+            if (isUserResizable)
+            {
+                hints.min_width = scast<int>(minSize.x);
+                hints.min_height = scast<int>(minSize.y);
+                hints.max_width = scast<int>(maxSize.x);
+                hints.max_height = scast<int>(maxSize.y);
+            }
+            else
+            {
+                hints.min_width = hints.max_width = scast<int>(fixedSize.x);
+                hints.min_height = hints.max_height = scast<int>(fixedSize.y);
+            }
+
+            XSetWMNormalHints(display, window, &hints);
+        }
+
+        //leaving fullscreen or maximized must happen before the old rect is restored,
+        //entering them after it so the WM remembers the rect to restore to later
+        bool isRestoring =
+            (changes.hasWindowMode
+            && changes.windowMode == WindowMode::WINDOWMODE_WINDOWED)
+            || (changes.hasWindowState
+            && (changes.windowState == WindowState::WINDOW_NORMAL
+            || changes.windowState == WindowState::WINDOW_SHOWNOACTIVATE));
+
+        if (isRestoring) sendModeAndState();
+
+        if (changes.hasPosition
+            && changes.hasSize)
+        {
+            XMoveResizeWindow(
+                display,
+                window,
+                scast<int>(changes.position.x),
+                scast<int>(changes.position.y),
+                scast<u32>(changes.size.x),
+                scast<u32>(changes.size.y));
+        }
+        else if (changes.hasPosition)
+        {
+            XMoveWindow(
+                display,
+                window,
+                scast<int>(changes.position.x),
+                scast<int>(changes.position.y));
+        }
+        else if (changes.hasSize)
+        {
+            XResizeWindow(
+                display,
+                window,
+                scast<u32>(changes.size.x),
+                scast<u32>(changes.size.y));
+        }
+
+        if (!isRestoring) sendModeAndState();
+
+        if (changes.hasAlwaysOnTop)
+        {
+            Atom atom_net_wm_state_above = ToVar<Atom>(globalData.atom_net_wm_state_above);
+            sendStateMessage(changes.isAlwaysOnTop, atom_net_wm_state_above, 0, 0);
+        }
+    }
+
+    void ProcessWindow::SendAllPendingChanges()
+    {
+        if (changedWindowIDs.empty()) return;
+
+        //sending never queues new changes, but a window may have been destroyed since it queued
+        vector<u32> sendIDs = std::move(changedWindowIDs);
+        changedWindowIDs.clear();
+
+        for (u32 sendID : sendIDs)
+        {
+            ProcessWindow* pw = registry.GetContent(sendID);
+            if (!pw
+                || pw->IsPendingDestroy())
+            {
+                continue;
+            }
+
+            pw->SendPendingChanges();
+        }
+    }
+
     void ProcessWindow::Destroy()
     {
+        //the desktop mode comes back right away even if the window itself goes at the end of Update
+        RestoreExclusiveDisplayMode();
+
+        //tearing the window down now would pull it out from under the update loops,
+        //so during Update it is only marked and queued for DestroyPending
+        if (isUpdating)
+        {
+            WindowHotState* hot = GetHotState();
+            if (!hot
+                || hot->isPendingDestroy)
+            {
+                return;
+            }
+
+            hot->isPendingDestroy = true;
+            pendingDestroyIDs.push_back(ID);
+
+            //children go down with their parent, skip them for the rest of the frame too
+            for (u32 childID : childIDs)
+            {
+                ProcessWindow* pw = registry.GetContent(childID);
+                if (pw) pw->Destroy();
+            }
+
+            return;
+        }
+
+        DestroyNow();
+    }
+
+    bool ProcessWindow::IsPendingDestroy() const
+    {
+        const WindowHotState* hot = GetHotState();
+        return hot && hot->isPendingDestroy;
+    }
+
+    void ProcessWindow::DestroyPending()
+    {
+        if (pendingDestroyIDs.empty()) return;
+
+        //a shutdown callback may destroy more windows, those are torn down right away
+        vector<u32> destroyIDs = std::move(pendingDestroyIDs);
+        pendingDestroyIDs.clear();
+
+        //parents tear down their own children, so queued children may already be gone
+        for (u32 destroyID : destroyIDs)
+        {
+            ProcessWindow* pw = registry.GetContent(destroyID);
+            if (pw) pw->DestroyNow();
+        }
+    }
+
+    void ProcessWindow::DestroyNow()
+    {
+        auto pooledIt = find(pooledWindowIDs.begin(), pooledWindowIDs.end(), ID);
+        if (pooledIt != pooledWindowIDs.end())
+        {
+            pooledWindowIDs.erase(pooledIt);
+        }
+        //pooled windows do not keep the program running, they go first when the last real window closes
+        else if (registry.GetAllContent().size() == pooledWindowIDs.size() + 1)
+        {
+            vector<u32> poolIDs = std::move(pooledWindowIDs);
+            pooledWindowIDs.clear();
+
+            for (u32 poolID : poolIDs)
+            {
+                ProcessWindow* pw = registry.GetContent(poolID);
+                if (pw) pw->DestroyNow();
+            }
+        }
+
 		if (registry.GetAllContent().size() == 1)
 		{
 			Log::Print(
@@ -1620,6 +2816,7 @@ namespace KalaWindow::Graphics
 		}
 
         KalaWindowRegistry<VulkanContext>::RemoveAllWindowContent(ID);
+        KalaWindowRegistry<SoftwareFramebuffer>::RemoveAllWindowContent(ID);
 
 		KalaWindowRegistry<Input>::RemoveAllWindowContent(ID);
 		
@@ -1635,7 +2832,6 @@ namespace KalaWindow::Graphics
 			"KW_WINDOW",
 			LogType::LOG_INFO);
 
-		inputID = 0;
 		graphicsContextID = 0;
 
         const X11GlobalData& globalData = Window_Global::GetGlobalData();
@@ -1647,7 +2843,10 @@ namespace KalaWindow::Graphics
             XIC xic = ToVar<XIC>(windowData.xic);
 
             XDestroyWindow(display, window);
-            XDestroyIC(xic);
+            if (xic) XDestroyIC(xic);
+
+            if (syncCounter) XSyncDestroyCounter(display, ToVar<XSyncCounter>(syncCounter));
+            if (extendedSyncCounter) XSyncDestroyCounter(display, ToVar<XSyncCounter>(extendedSyncCounter));
         }
 
         if (registry.GetAllContent().empty())
@@ -1655,6 +2854,9 @@ namespace KalaWindow::Graphics
 			const X11GlobalData& globalData = Window_Global::GetGlobalData();
 			if (globalData.display)
 			{
+				//needs the display, so it can not wait for Window_Global::Shutdown
+				Window_Global::RestoreAllCrtcModes();
+
 				XIM xim = ToVar<XIM>(globalData.xim);
 				XCloseIM(xim);
 
@@ -1665,6 +2867,9 @@ namespace KalaWindow::Graphics
             //shuts down x11 libnotify and libcanberra
             Window_Global::Shutdown();
 
+            //the reader thread must be joined before exit destroys it
+            Gamepad::Shutdown();
+
 			Log::Print(
                 "\n======================================================================"
                 "\nFINISHED SHUTDOWN"